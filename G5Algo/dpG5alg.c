@@ -16,9 +16,17 @@
 #include "dpjtag.h"
 #include "dpalg.h"
 #include "dpcom.h"
+#include "dptimer.h"
 #include "dputil.h"
+#include "dpdigest.h"
+#include "dphistory.h"
+#include "dpimage.h"
+#include "dpmetrics.h"
 #include "dpG5alg.h"
 
+#include <string.h>
+#include <time.h>
+
 unsigned char g5_pgmmode;
 unsigned char g5_pgmmode_flag;
 unsigned char g5_shared_buf[1024];
@@ -27,6 +35,8 @@ unsigned long g5_poll_index;
 unsigned char g5_component_digest[32];
 unsigned char g5_component_type;
 unsigned char g5_componenet_Supports_Cert;
+unsigned char g5_bitstream_digest[G5M_BSDIGEST_BYTE_SIZE];
+unsigned char g5_record_digests;
 
 unsigned int g5_prev_failed_component = 0;
 unsigned long g5_prev_failed_block = 0;
@@ -58,6 +68,7 @@ void dp_init_G5_vars(void)
 {
 	g5_pgmmode = 0u;
 	g5_pgmmode_flag = FALSE;
+	g5_record_digests = FALSE;
 
 	return;
 }
@@ -71,6 +82,7 @@ void dp_check_G5_action(void)
 #endif
 	} else if (!((Action_code == DP_ERASE_ACTION_CODE) ||
 		     (Action_code == DP_PROGRAM_ACTION_CODE) ||
+		     (Action_code == DP_PROGRAM_IF_DIFFERENT_ACTION_CODE) ||
 		     (Action_code == DP_VERIFY_ACTION_CODE) ||
 		     (Action_code == DP_ENC_DATA_AUTHENTICATION_ACTION_CODE) ||
 		     (Action_code == DP_VERIFY_DIGEST_ACTION_CODE) ||
@@ -88,6 +100,7 @@ void dp_check_G5_action(void)
 void dp_perform_G5_action(struct gpio_handle *jtag_gpio)
 {
 	Action_done = FALSE;
+	dp_timer_begin_phase("poll ready", 0u);
 	dp_G5M_poll_device_ready(jtag_gpio);
 	if (error_code == DPE_SUCCESS) {
 		switch (Action_code) {
@@ -115,8 +128,10 @@ void dp_perform_G5_action(struct gpio_handle *jtag_gpio)
 #endif
 		}
 		if (Action_done == FALSE) {
+			dp_timer_begin_phase("crc", 0u);
 			dp_G5M_display_bitstream_digest();
 			dp_check_image_crc();
+			dp_timer_begin_phase("action", 0u);
 			if (error_code == DPE_SUCCESS) {
 				dp_check_G5_device_ID();
 				if (error_code == DPE_SUCCESS) {
@@ -129,6 +144,10 @@ void dp_perform_G5_action(struct gpio_handle *jtag_gpio)
 						Action_done = TRUE;
 						dp_G5M_program_action(jtag_gpio);
 						break;
+					case DP_PROGRAM_IF_DIFFERENT_ACTION_CODE:
+						Action_done = TRUE;
+						dp_G5M_program_if_different_action(jtag_gpio);
+						break;
 					case DP_VERIFY_ACTION_CODE:
 						Action_done = TRUE;
 						dp_G5M_verify_action(jtag_gpio);
@@ -146,6 +165,14 @@ void dp_perform_G5_action(struct gpio_handle *jtag_gpio)
 			}
 		}
 		dp_G5M_exit(jtag_gpio);
+		if ((g5_record_digests == TRUE) && (error_code == DPE_SUCCESS)) {
+			dp_G5M_record_digests(jtag_gpio);
+		}
+#ifdef ENABLE_HISTORY
+		if (Action_code != DP_READ_IDCODE_ACTION_CODE) {
+			dp_G5M_record_history(jtag_gpio);
+		}
+#endif
 	}
 	return;
 }
@@ -202,6 +229,68 @@ void dp_G5M_program_action(struct gpio_handle *jtag_gpio)
 	return;
 }
 
+/*
+ * Module: dp_G5M_program_if_different_action
+ * 		purpose: Skips programming when the device returns the segment digests recorded
+ *		after this DAT file was last programmed, see dpdigest.h.  Otherwise the device is
+ *		programmed as with the program action and the digests are recorded once
+ *		dp_G5M_exit left programming mode.  Files without a BITS component are always
+ *		programmed.
+ *
+ */
+void dp_G5M_program_if_different_action(struct gpio_handle *jtag_gpio)
+{
+#ifdef ENABLE_DISPLAY
+	dp_display_text("\r\nPerforming PROGRAM_IF_DIFFERENT action: ");
+#endif
+	if (dp_G5M_get_bitstream_digest(g5_bitstream_digest) == TRUE) {
+		dp_G5M_query_digests(jtag_gpio);
+		if ((error_code == DPE_SUCCESS) &&
+		    (dp_digest_matches(g5_bitstream_digest, g5_shared_buf) == TRUE)) {
+#ifdef ENABLE_DISPLAY
+			dp_display_text(
+			    "\r\nThe device digests match the last programming of this file.  "
+			    "Programming skipped.");
+#endif
+			return;
+		}
+		/* A device that can't report its digests is programmed */
+		error_code = DPE_SUCCESS;
+		g5_record_digests = TRUE;
+	}
+	dp_G5M_program_action(jtag_gpio);
+	if (error_code != DPE_SUCCESS) {
+		g5_record_digests = FALSE;
+	}
+
+	return;
+}
+
+/*
+ * Module: dp_G5M_record_digests
+ * 		purpose: Reads the segment digests of the device that was just programmed and records
+ *		them for the next program_if_different run.  A failure to read them is reported
+ *		but does not fail the programming that passed.
+ *
+ */
+void dp_G5M_record_digests(struct gpio_handle *jtag_gpio)
+{
+	dp_timer_begin_phase("record digests", 0u);
+	dp_G5M_query_digests(jtag_gpio);
+	if (error_code == DPE_SUCCESS) {
+		dp_digest_record(g5_bitstream_digest, g5_shared_buf);
+	} else {
+#ifdef ENABLE_DISPLAY
+		dp_display_text("\r\nWarning: failed to read the digests back, the next run will "
+				"program again.");
+#endif
+		error_code = DPE_SUCCESS;
+	}
+	g5_record_digests = FALSE;
+
+	return;
+}
+
 void dp_G5M_do_program(struct gpio_handle *jtag_gpio)
 {
 #ifdef ENABLE_DISPLAY
@@ -675,32 +764,23 @@ void dp_G5M_read_dibs(struct gpio_handle *jtag_gpio)
 
 void dp_G5M_read_design_info(struct gpio_handle *jtag_gpio)
 {
-	opcode = G5M_READ_DESIGN_INFO;
-	IRSCAN_in(jtag_gpio);
-	DRSCAN_in(jtag_gpio, 0u, G5M_STATUS_REGISTER_BIT_LENGTH, (unsigned char *)(unsigned char *)DPNULL);
-	goto_jtag_state(jtag_gpio, JTAG_RUN_TEST_IDLE, G5M_STANDARD_CYCLES);
-	dp_delay(G5M_STANDARD_DELAY);
-	opcode = G5M_READ_DESIGN_INFO;
-	dp_G5M_device_poll(jtag_gpio, 8u, 7u);
+	dp_G5M_query_design_info(jtag_gpio);
 	if (error_code == DPE_SUCCESS) {
-		dp_G5M_read_shared_buffer(jtag_gpio, 3u);
-		if (error_code == DPE_SUCCESS) {
-			dp_display_text("\r\nDesign Name: ");
+		dp_display_text("\r\nDesign Name: ");
 
-			for (global_uchar1 = 2u; global_uchar1 < 32u; global_uchar1++) {
-				dp_display_value(g5_shared_buf[global_uchar1], CHR);
-			}
-			dp_display_text("\r\nChecksum: ");
-			dp_display_array(g5_shared_buf, 2u, HEX);
-			dp_display_text("\r\nDesign Info: \r\n");
-			dp_display_array(g5_shared_buf, 34u, HEX);
-			dp_display_text("\r\nDESIGNVER: ");
-			dp_display_array(&g5_shared_buf[32], 2u, HEX);
-			dp_display_text("\r\nBACKLEVEL: ");
-			dp_display_array(&g5_shared_buf[34], 2u, HEX);
-			dp_display_text(
-			    "\r\n-----------------------------------------------------");
+		for (global_uchar1 = 2u; global_uchar1 < 32u; global_uchar1++) {
+			dp_display_value(g5_shared_buf[global_uchar1], CHR);
 		}
+		dp_display_text("\r\nChecksum: ");
+		dp_display_array(g5_shared_buf, 2u, HEX);
+		dp_display_text("\r\nDesign Info: \r\n");
+		dp_display_array(g5_shared_buf, 34u, HEX);
+		dp_display_text("\r\nDESIGNVER: ");
+		dp_display_array(&g5_shared_buf[32], 2u, HEX);
+		dp_display_text("\r\nBACKLEVEL: ");
+		dp_display_array(&g5_shared_buf[34], 2u, HEX);
+		dp_display_text(
+		    "\r\n-----------------------------------------------------");
 	}
 
 	return;
@@ -708,55 +788,46 @@ void dp_G5M_read_design_info(struct gpio_handle *jtag_gpio)
 
 void dp_G5M_read_digests(struct gpio_handle *jtag_gpio)
 {
-	opcode = G5M_READ_DIGEST;
-	IRSCAN_in(jtag_gpio);
-	DRSCAN_in(jtag_gpio, 0u, G5M_STATUS_REGISTER_BIT_LENGTH, (unsigned char *)(unsigned char *)DPNULL);
-	goto_jtag_state(jtag_gpio, JTAG_RUN_TEST_IDLE, G5M_STANDARD_CYCLES);
-	dp_delay(G5M_STANDARD_DELAY);
-	opcode = G5M_READ_DIGEST;
-	dp_G5M_device_poll(jtag_gpio, 8u, 7u);
+	dp_G5M_query_digests(jtag_gpio);
 	if (error_code == DPE_SUCCESS) {
-		dp_G5M_read_shared_buffer(jtag_gpio, 26u);
-		if (error_code == DPE_SUCCESS) {
-			dp_display_text("\r\nFabric digest: ");
-			dp_display_array(&g5_shared_buf[0], 32u, HEX);
+		dp_display_text("\r\nFabric digest: ");
+		dp_display_array(&g5_shared_buf[0], 32u, HEX);
 
-			dp_display_text("\r\nUFS CC segment digest: ");
-			dp_display_array(&g5_shared_buf[32], 32u, HEX);
+		dp_display_text("\r\nUFS CC segment digest: ");
+		dp_display_array(&g5_shared_buf[32], 32u, HEX);
 
-			dp_display_text("\r\nSNVM digest: ");
-			dp_display_array(&g5_shared_buf[64], 32u, HEX);
+		dp_display_text("\r\nSNVM digest: ");
+		dp_display_array(&g5_shared_buf[64], 32u, HEX);
 
-			dp_display_text("\r\nUFS UL digest: ");
-			dp_display_array(&g5_shared_buf[96], 32u, HEX);
+		dp_display_text("\r\nUFS UL digest: ");
+		dp_display_array(&g5_shared_buf[96], 32u, HEX);
 
-			dp_display_text("\r\nUser Key digest 0: ");
-			dp_display_array(&g5_shared_buf[128], 32u, HEX);
+		dp_display_text("\r\nUser Key digest 0: ");
+		dp_display_array(&g5_shared_buf[128], 32u, HEX);
 
-			dp_display_text("\r\nUser Key digest 1: ");
-			dp_display_array(&g5_shared_buf[160], 32u, HEX);
+		dp_display_text("\r\nUser Key digest 1: ");
+		dp_display_array(&g5_shared_buf[160], 32u, HEX);
 
-			dp_display_text("\r\nUser Key digest 2: ");
-			dp_display_array(&g5_shared_buf[192], 32u, HEX);
+		dp_display_text("\r\nUser Key digest 2: ");
+		dp_display_array(&g5_shared_buf[192], 32u, HEX);
 
-			dp_display_text("\r\nUser Key digest 3: ");
-			dp_display_array(&g5_shared_buf[224], 32u, HEX);
+		dp_display_text("\r\nUser Key digest 3: ");
+		dp_display_array(&g5_shared_buf[224], 32u, HEX);
 
-			dp_display_text("\r\nUser Key digest 4: ");
-			dp_display_array(&g5_shared_buf[256], 32u, HEX);
+		dp_display_text("\r\nUser Key digest 4: ");
+		dp_display_array(&g5_shared_buf[256], 32u, HEX);
 
-			dp_display_text("\r\nUser Key digest 5: ");
-			dp_display_array(&g5_shared_buf[288], 32u, HEX);
+		dp_display_text("\r\nUser Key digest 5: ");
+		dp_display_array(&g5_shared_buf[288], 32u, HEX);
 
-			dp_display_text("\r\nUser Key digest 6: ");
-			dp_display_array(&g5_shared_buf[320], 32u, HEX);
+		dp_display_text("\r\nUser Key digest 6: ");
+		dp_display_array(&g5_shared_buf[320], 32u, HEX);
 
-			dp_display_text("\r\nUFS UPERM segment digest: ");
-			dp_display_array(&g5_shared_buf[352], 32u, HEX);
+		dp_display_text("\r\nUFS UPERM segment digest: ");
+		dp_display_array(&g5_shared_buf[352], 32u, HEX);
 
-			dp_display_text("\r\nFactory digest: ");
-			dp_display_array(&g5_shared_buf[384], 32u, HEX);
-		}
+		dp_display_text("\r\nFactory digest: ");
+		dp_display_array(&g5_shared_buf[384], 32u, HEX);
 	}
 
 	return;
@@ -765,18 +836,9 @@ void dp_G5M_read_digests(struct gpio_handle *jtag_gpio)
 void dp_G5M_check_cycle_count(struct gpio_handle *jtag_gpio)
 {
 	unsigned int cycle_count = 0;
-	opcode = G5M_READ_DEBUG_INFO;
-	IRSCAN_in(jtag_gpio);
-	DRSCAN_in(jtag_gpio, 0u, G5M_STATUS_REGISTER_BIT_LENGTH, (unsigned char *)(unsigned char *)DPNULL);
-	goto_jtag_state(jtag_gpio, JTAG_RUN_TEST_IDLE, G5M_STANDARD_CYCLES);
-	dp_delay(G5M_STANDARD_DELAY);
 
-	opcode = G5M_READ_DEBUG_INFO;
-	dp_G5M_device_poll(jtag_gpio, 128u, 127u);
+	cycle_count = dp_G5M_query_cycle_count(jtag_gpio);
 	if (error_code == DPE_SUCCESS) {
-		dp_G5M_read_shared_buffer(jtag_gpio, 6u);
-
-		cycle_count = ((g5_shared_buf[61] << 8u) | (g5_shared_buf[60]));
 #ifdef ENABLE_DISPLAY
 
 		dp_display_text("\r\nCYCLE COUNT: ");
@@ -865,12 +927,7 @@ void dp_G5M_read_tvs_monitor(struct gpio_handle *jtag_gpio)
 
 void dp_G5M_read_fsn(struct gpio_handle *jtag_gpio)
 {
-	opcode = G5M_READ_FSN;
-	IRSCAN_in(jtag_gpio);
-	DRSCAN_in(jtag_gpio, 0u, G5M_STATUS_REGISTER_BIT_LENGTH, (unsigned char *)(unsigned char *)DPNULL);
-	goto_jtag_state(jtag_gpio, JTAG_RUN_TEST_IDLE, G5M_STANDARD_CYCLES);
-	opcode = G5M_READ_FSN;
-	dp_G5M_device_poll(jtag_gpio, 129u, 128u);
+	dp_G5M_query_fsn(jtag_gpio);
 	if ((error_code != DPE_SUCCESS) && (unique_exit_code == DPE_SUCCESS)) {
 		unique_exit_code = 32769;
 		dp_display_text("\r\nFailed to read DSN.\r\nERROR_CODE: ");
@@ -889,7 +946,171 @@ void dp_G5M_read_fsn(struct gpio_handle *jtag_gpio)
 }
 #endif
 
+/* Reads the DSN of the device into g5_poll_buf */
+void dp_G5M_query_fsn(struct gpio_handle *jtag_gpio)
+{
+	opcode = G5M_READ_FSN;
+	IRSCAN_in(jtag_gpio);
+	DRSCAN_in(jtag_gpio, 0u, G5M_STATUS_REGISTER_BIT_LENGTH, (unsigned char *)(unsigned char *)DPNULL);
+	goto_jtag_state(jtag_gpio, JTAG_RUN_TEST_IDLE, G5M_STANDARD_CYCLES);
+	opcode = G5M_READ_FSN;
+	dp_G5M_device_poll(jtag_gpio, 129u, 128u);
+
+	return;
+}
+
+/* Reads the design name, checksum and version of the device into g5_shared_buf */
+void dp_G5M_query_design_info(struct gpio_handle *jtag_gpio)
+{
+	opcode = G5M_READ_DESIGN_INFO;
+	IRSCAN_in(jtag_gpio);
+	DRSCAN_in(jtag_gpio, 0u, G5M_STATUS_REGISTER_BIT_LENGTH, (unsigned char *)(unsigned char *)DPNULL);
+	goto_jtag_state(jtag_gpio, JTAG_RUN_TEST_IDLE, G5M_STANDARD_CYCLES);
+	dp_delay(G5M_STANDARD_DELAY);
+	opcode = G5M_READ_DESIGN_INFO;
+	dp_G5M_device_poll(jtag_gpio, 8u, 7u);
+	if (error_code == DPE_SUCCESS) {
+		dp_G5M_read_shared_buffer(jtag_gpio, 3u);
+	}
+
+	return;
+}
+
+/* Reads the 13 segment digests of the device into g5_shared_buf */
+void dp_G5M_query_digests(struct gpio_handle *jtag_gpio)
+{
+	opcode = G5M_READ_DIGEST;
+	IRSCAN_in(jtag_gpio);
+	DRSCAN_in(jtag_gpio, 0u, G5M_STATUS_REGISTER_BIT_LENGTH, (unsigned char *)(unsigned char *)DPNULL);
+	goto_jtag_state(jtag_gpio, JTAG_RUN_TEST_IDLE, G5M_STANDARD_CYCLES);
+	dp_delay(G5M_STANDARD_DELAY);
+	opcode = G5M_READ_DIGEST;
+	dp_G5M_device_poll(jtag_gpio, 8u, 7u);
+	if (error_code == DPE_SUCCESS) {
+		dp_G5M_read_shared_buffer(jtag_gpio, 26u);
+	}
+
+	return;
+}
+
+/*
+ * Module: dp_G5M_query_cycle_count
+ * 		purpose: Reads the debug info of the device into g5_shared_buf.
+ * Return value:
+ * 		The programming cycle count, 0xffff if the device doesn't report it.
+ *
+ */
+unsigned int dp_G5M_query_cycle_count(struct gpio_handle *jtag_gpio)
+{
+	opcode = G5M_READ_DEBUG_INFO;
+	IRSCAN_in(jtag_gpio);
+	DRSCAN_in(jtag_gpio, 0u, G5M_STATUS_REGISTER_BIT_LENGTH, (unsigned char *)(unsigned char *)DPNULL);
+	goto_jtag_state(jtag_gpio, JTAG_RUN_TEST_IDLE, G5M_STANDARD_CYCLES);
+	dp_delay(G5M_STANDARD_DELAY);
+
+	opcode = G5M_READ_DEBUG_INFO;
+	dp_G5M_device_poll(jtag_gpio, 128u, 127u);
+	if (error_code == DPE_SUCCESS) {
+		dp_G5M_read_shared_buffer(jtag_gpio, 6u);
+		if (error_code == DPE_SUCCESS) {
+			return (unsigned int)((g5_shared_buf[61] << 8u) | (g5_shared_buf[60]));
+		}
+	}
+
+	return 0xffffu;
+}
+
+#ifdef ENABLE_HISTORY
+/*
+ * Module: dp_G5M_record_history
+ * 		purpose: Appends the action that just ended to the history, with the DSN, design,
+ *		digests and cycle count read back from the device, see dphistory.h.  The error and
+ *		exit codes of the action are kept whatever these reads return.  Nothing is recorded
+ *		for a device whose DSN can't be read.
+ *
+ */
+void dp_G5M_record_history(struct gpio_handle *jtag_gpio)
+{
+	struct dp_history_record record;
+	unsigned char action_error_code = error_code;
+	unsigned int action_exit_code = unique_exit_code;
+	unsigned int length;
+
+	memset(&record, 0, sizeof(record));
+	/* The history reads are not part of the duration of the action */
+	record.time = (unsigned int)time(NULL);
+	record.duration_ms = (unsigned int)dp_timer_action_ms();
+	record.action = Action_code;
+	record.result = action_error_code;
+	record.cycle_count = DP_HISTORY_NO_CYCLE_COUNT;
+	dp_timer_begin_phase("history", 0u);
+
+	error_code = DPE_SUCCESS;
+	dp_G5M_query_fsn(jtag_gpio);
+	if (error_code == DPE_SUCCESS) {
+		memcpy(record.dsn, g5_poll_buf, DP_HISTORY_DSN_SIZE);
+
+		dp_G5M_query_design_info(jtag_gpio);
+		if (error_code == DPE_SUCCESS) {
+			memcpy(record.design_checksum, &g5_shared_buf[0], 2u);
+			memcpy(record.design_version, &g5_shared_buf[32], 2u);
+			/* The name is padded with spaces or zeros, the history pads it with zeros */
+			length = DP_HISTORY_DESIGN_SIZE;
+			while ((length > 0u) && ((g5_shared_buf[1u + length] == ' ') ||
+						 (g5_shared_buf[1u + length] == 0u))) {
+				length--;
+			}
+			memcpy(record.design_name, &g5_shared_buf[2], length);
+		}
+
+		error_code = DPE_SUCCESS;
+		dp_G5M_query_digests(jtag_gpio);
+		if (error_code == DPE_SUCCESS) {
+			memcpy(record.fabric_digest, &g5_shared_buf[0], DP_HISTORY_DIGEST_SIZE);
+			memcpy(record.snvm_digest, &g5_shared_buf[64], DP_HISTORY_DIGEST_SIZE);
+		}
+
+		error_code = DPE_SUCCESS;
+		record.cycle_count = (unsigned short)dp_G5M_query_cycle_count(jtag_gpio);
+
+		if ((selected_image != (struct dp_image *)DPNULL) ||
+		    (image_buffer != (unsigned char *)DPNULL)) {
+			dp_G5M_get_bitstream_digest(record.bitstream_digest);
+		}
+		dp_history_append(&record);
+	}
+	error_code = action_error_code;
+	unique_exit_code = action_exit_code;
+
+	return;
+}
+#endif
+
 /* Checking device ID function.  ID is already read in dpalg.c */
+/*
+ * Module: dp_G5M_check_device_exception
+ * 		purpose: MPF300 engineering sample and production devices share their IDCODE but
+ *		need different programming files.  Checks that a file built for device_exception
+ *		can be used on a device of the given revision.
+ * Return value:
+ * 		0 if it can, otherwise the unique exit code reported for the mismatch.
+ *
+ */
+unsigned int dp_G5M_check_device_exception(unsigned char exception, unsigned char revision)
+{
+	if (((exception == MPF300T_ES_DEVICE_CODE) || (exception == MPF300TS_ES_DEVICE_CODE) ||
+	     (exception == MPF300XT_DEVICE_CODE)) &&
+	    (revision > 4u)) {
+		return 32857u;
+	}
+	if (((exception == MPF300T_DEVICE_CODE) || (exception == MPF300TS_DEVICE_CODE) ||
+	     (exception == MPF300TL_DEVICE_CODE) || (exception == MPF300TLS_DEVICE_CODE)) &&
+	    (revision < 5u)) {
+		return 32858u;
+	}
+	return 0u;
+}
+
 void dp_check_G5_device_ID(void)
 {
 	/* DataIndex is a variable used for loading the array data but not used now.
@@ -907,10 +1128,8 @@ void dp_check_G5_device_ID(void)
 
 	if ((DataIndex & 0xfff) == MICROSEMI_ID) {
 		if (device_ID == DataIndex) {
-			if (((device_exception == MPF300T_ES_DEVICE_CODE) ||
-			     (device_exception == MPF300TS_ES_DEVICE_CODE) ||
-			     (device_exception == MPF300XT_DEVICE_CODE)) &&
-			    (device_rev > 4u)) {
+			global_uint1 = dp_G5M_check_device_exception(device_exception, device_rev);
+			if (global_uint1 == 32857u) {
 				unique_exit_code = 32857;
 				error_code = DPE_IDCODE_ERROR;
 #ifdef ENABLE_DISPLAY
@@ -922,11 +1141,7 @@ void dp_check_G5_device_ID(void)
 				dp_display_text("\r\nERROR_CODE: ");
 				dp_display_value(unique_exit_code, HEX);
 #endif
-			} else if (((device_exception == MPF300T_DEVICE_CODE) ||
-				    (device_exception == MPF300TS_DEVICE_CODE) ||
-				    (device_exception == MPF300TL_DEVICE_CODE) ||
-				    (device_exception == MPF300TLS_DEVICE_CODE)) &&
-				   (device_rev < 5u)) {
+			} else if (global_uint1 == 32858u) {
 				unique_exit_code = 32858;
 				error_code = DPE_IDCODE_ERROR;
 #ifdef ENABLE_DISPLAY
@@ -968,9 +1183,23 @@ void dp_check_G5_device_ID(void)
 	return;
 }
 
+#ifdef ENABLE_METRICS
+/* Accounts for the poll loop of opcode that started at start_ns and ended at g5_poll_index */
+static void dp_G5M_account_poll(unsigned long max_poll, unsigned long long start_ns)
+{
+	dp_metrics_poll(opcode, (g5_poll_index > max_poll) ? g5_poll_index : g5_poll_index + 1u,
+			dp_timer_ns() - start_ns);
+	return;
+}
+#endif
+
 /* Check if system controller is ready to enter programming mode */
 void dp_G5M_device_poll(struct gpio_handle *jtag_gpio, unsigned char bits_to_shift, unsigned char Busy_bit)
 {
+#ifdef ENABLE_METRICS
+	unsigned long long poll_start = dp_timer_ns();
+#endif
+	dp_timer_start_operation();
 	for (g5_poll_index = 0U; g5_poll_index <= G5M_MAX_CONTROLLER_POLL; g5_poll_index++) {
 		IRSCAN_in(jtag_gpio);
 		DRSCAN_out(jtag_gpio, bits_to_shift, (unsigned char *)DPNULL, g5_poll_buf);
@@ -978,7 +1207,12 @@ void dp_G5M_device_poll(struct gpio_handle *jtag_gpio, unsigned char bits_to_shi
 		if (((g5_poll_buf[Busy_bit / 8] & (1 << (Busy_bit % 8))) == 0x0u)) {
 			break;
 		}
+		if (dp_timer_expired() == TRUE)
+			break;
 	}
+#ifdef ENABLE_METRICS
+	dp_G5M_account_poll(G5M_MAX_CONTROLLER_POLL, poll_start);
+#endif
 	if (g5_poll_index > G5M_MAX_CONTROLLER_POLL) {
 #ifdef ENABLE_DISPLAY
 		dp_display_text("\r\nDevice polling failed: ");
@@ -993,6 +1227,10 @@ void dp_G5M_device_poll(struct gpio_handle *jtag_gpio, unsigned char bits_to_shi
 void dp_G5M_device_shift_and_poll(struct gpio_handle *jtag_gpio, unsigned char bits_to_shift,
 				  unsigned char Busy_bit, unsigned char Variable_ID, unsigned long start_bit_index)
 {
+#ifdef ENABLE_METRICS
+	unsigned long long poll_start = dp_timer_ns();
+#endif
+	dp_timer_start_operation();
 	for (g5_poll_index = 0U; g5_poll_index <= G5M_MAX_CONTROLLER_POLL; g5_poll_index++) {
 		IRSCAN_in(jtag_gpio);
 		dp_get_and_DRSCAN_in_out(jtag_gpio, Variable_ID, bits_to_shift, start_bit_index,
@@ -1002,7 +1240,12 @@ void dp_G5M_device_shift_and_poll(struct gpio_handle *jtag_gpio, unsigned char b
 		if (((g5_poll_buf[Busy_bit / 8] & (1 << (Busy_bit % 8))) == 0x0u)) {
 			break;
 		}
+		if (dp_timer_expired() == TRUE)
+			break;
 	}
+#ifdef ENABLE_METRICS
+	dp_G5M_account_poll(G5M_MAX_CONTROLLER_POLL, poll_start);
+#endif
 	if (g5_poll_index > G5M_MAX_CONTROLLER_POLL) {
 #ifdef ENABLE_DISPLAY
 		dp_display_text("\r\nDevice polling failed.");
@@ -1037,7 +1280,11 @@ void dp_G5M_read_shared_buffer(struct gpio_handle *jtag_gpio, unsigned char ucNu
 
 void dp_G5M_poll_device_ready(struct gpio_handle *jtag_gpio)
 {
+#ifdef ENABLE_METRICS
+	unsigned long long poll_start = dp_timer_ns();
+#endif
 	opcode = G5M_ISC_NOOP;
+	dp_timer_start_operation();
 	for (g5_poll_index = 0U; g5_poll_index <= G5M_MAX_CONTROLLER_POLL; g5_poll_index++) {
 		IRSCAN_in(jtag_gpio);
 		goto_jtag_state(jtag_gpio, JTAG_RUN_TEST_IDLE, G5M_STANDARD_CYCLES);
@@ -1047,7 +1294,12 @@ void dp_G5M_poll_device_ready(struct gpio_handle *jtag_gpio)
 		if ((g5_poll_buf[0] & 0x80u) == 0x0u) {
 			break;
 		}
+		if (dp_timer_expired() == TRUE)
+			break;
 	}
+#ifdef ENABLE_METRICS
+	dp_G5M_account_poll(G5M_MAX_CONTROLLER_POLL, poll_start);
+#endif
 	if (g5_poll_index > G5M_MAX_CONTROLLER_POLL) {
 		error_code = DPE_POLL_ERROR;
 		unique_exit_code = 32818;
@@ -1087,6 +1339,11 @@ void dp_G5M_load_bsr(struct gpio_handle *jtag_gpio)
 	unsigned char mask;
 	unsigned char c_mask;
 	unsigned int bsr_bits;
+	unsigned int bsr_bytes;
+	unsigned char *pattern_data;
+	unsigned char *mask_data;
+	unsigned long pattern_span;
+	unsigned long mask_span;
 
 	dp_G5M_check_core_status(jtag_gpio);
 
@@ -1107,8 +1364,13 @@ void dp_G5M_load_bsr(struct gpio_handle *jtag_gpio)
 	/* Capturing the last known state of the IOs is only valid if the core
 	was programmed.  Otherwise, load the BSR with what is in the data file. */
 	if (core_is_enabled == 1) {
-		for (index = 0; index < (unsigned int)(bsr_bits + 7u) / 8u; index++) {
-			if (dp_get_bytes(G5M_BsrPatternMask_ID, index, 1u) != 0) {
+		bsr_bytes = (bsr_bits + 7u) / 8u;
+		mask_data = dp_get_block_span(G5M_BsrPatternMask_ID, 0u, &mask_span);
+		for (index = 0; index < bsr_bytes; index++) {
+			mask = (index < mask_span) ? mask_data[index]
+						   : (unsigned char)dp_get_bytes(G5M_BsrPatternMask_ID,
+									 index, 1u);
+			if (mask != 0) {
 				capture_last_known_io_state = 1;
 				break;
 			}
@@ -1124,10 +1386,24 @@ void dp_G5M_load_bsr(struct gpio_handle *jtag_gpio)
 				DRSCAN_out(jtag_gpio, bsr_bits, (unsigned char *)DPNULL,
 					   bsr_sample_buffer);
 
-				for (index = 0; index < (unsigned int)(bsr_bits + 7u) / 8u; index++) {
-					bsr_buffer[index] =
-					    dp_get_bytes(G5M_BsrPattern_ID, index, 1u);
-					mask = dp_get_bytes(G5M_BsrPatternMask_ID, index, 1u);
+				/* Merge straight from the image when both blocks are readable in
+				 * one span, which is always the case for an image in memory */
+				pattern_data =
+				    dp_get_block_span(G5M_BsrPattern_ID, 0u, &pattern_span);
+				mask_data =
+				    dp_get_block_span(G5M_BsrPatternMask_ID, 0u, &mask_span);
+				if ((pattern_span < bsr_bytes) || (mask_span < bsr_bytes)) {
+					pattern_data = (unsigned char *)DPNULL;
+				}
+				for (index = 0; index < bsr_bytes; index++) {
+					if (pattern_data != (unsigned char *)DPNULL) {
+						bsr_buffer[index] = pattern_data[index];
+						mask = mask_data[index];
+					} else {
+						bsr_buffer[index] =
+						    dp_get_bytes(G5M_BsrPattern_ID, index, 1u);
+						mask = dp_get_bytes(G5M_BsrPatternMask_ID, index, 1u);
+					}
 
 					if (mask != 0u) {
 						c_mask = ~mask;
@@ -1190,8 +1466,13 @@ void dp_G5M_perform_isc_enable(struct gpio_handle *jtag_gpio)
 /* Enter programming mode */
 void dp_G5M_initialize(struct gpio_handle *jtag_gpio)
 {
+	dp_timer_begin_phase("security query", 0u);
 	if (error_code == DPE_SUCCESS) {
 		dp_G5M_query_security(jtag_gpio);
+		if ((error_code == DPE_SUCCESS) &&
+		    ((g5_shared_buf[7] & (G5M_UL_USER_KEY1 | G5M_UL_USER_KEY2)) != 0u)) {
+			dp_timer_begin_phase("unlock", 0u);
+		}
 		if ((error_code == DPE_SUCCESS) &&
 		    ((g5_shared_buf[7] & G5M_UL_USER_KEY1) == G5M_UL_USER_KEY1)) {
 			dp_G5M_unlock_upk1(jtag_gpio);
@@ -1201,8 +1482,10 @@ void dp_G5M_initialize(struct gpio_handle *jtag_gpio)
 			dp_G5M_unlock_upk2(jtag_gpio);
 		}
 		if (error_code == DPE_SUCCESS) {
+			dp_timer_begin_phase("bsr load", 0u);
 			dp_G5M_load_bsr(jtag_gpio);
 			if (error_code == DPE_SUCCESS) {
+				dp_timer_begin_phase("isc enable", 0u);
 				dp_G5M_perform_isc_enable(jtag_gpio);
 			}
 		}
@@ -1213,7 +1496,11 @@ void dp_G5M_initialize(struct gpio_handle *jtag_gpio)
 
 void dp_G5M_poll_device_ready_during_exit(struct gpio_handle *jtag_gpio)
 {
+#ifdef ENABLE_METRICS
+	unsigned long long poll_start = dp_timer_ns();
+#endif
 	opcode = G5M_ISC_NOOP;
+	dp_timer_start_operation();
 	for (g5_poll_index = 0U; g5_poll_index <= G5M_MAX_EXIT_POLL; g5_poll_index++) {
 		IRSCAN_in(jtag_gpio);
 		goto_jtag_state(jtag_gpio, JTAG_RUN_TEST_IDLE, G5M_STANDARD_CYCLES);
@@ -1223,7 +1510,12 @@ void dp_G5M_poll_device_ready_during_exit(struct gpio_handle *jtag_gpio)
 		if ((g5_poll_buf[0] & 0x80u) == 0x0u) {
 			break;
 		}
+		if (dp_timer_expired() == TRUE)
+			break;
 	}
+#ifdef ENABLE_METRICS
+	dp_G5M_account_poll(G5M_MAX_EXIT_POLL, poll_start);
+#endif
 	if (g5_poll_index > G5M_MAX_CONTROLLER_POLL) {
 		error_code = DPE_POLL_ERROR;
 		unique_exit_code = 32818;
@@ -1232,8 +1524,15 @@ void dp_G5M_poll_device_ready_during_exit(struct gpio_handle *jtag_gpio)
 		dp_display_text("\r\nERROR_CODE: ");
 		dp_display_value(unique_exit_code, HEX);
 #endif
-	} else {
+	} else if ((dp_timer_abort_code() == DPE_SUCCESS) &&
+		   ((g5_pgmmode_flag == TRUE) || (Action_code == DP_ZEROIZE_LIKE_NEW_ACTION_CODE) ||
+		    (Action_code == DP_ZEROIZE_UNRECOVERABLE_ACTION_CODE))) {
+		/*
+		 * An abandoned action does not wait for the calibration, nor does one that left
+		 * the I/Os alone: no BSR load, programming mode or zeroization.
+		 */
 		// SAR 110023 wait for worst case IO calibration time.
+		dp_timer_begin_phase("io calibration", 0u);
 		goto_jtag_state(jtag_gpio, JTAG_RUN_TEST_IDLE, G5M_STANDARD_CYCLES);
 		dp_delay(G5M_IO_CALIBRATION_DELAY);
 	}
@@ -1244,6 +1543,7 @@ void dp_G5M_poll_device_ready_during_exit(struct gpio_handle *jtag_gpio)
 /* Function is used to exit programming mode */
 void dp_G5M_exit(struct gpio_handle *jtag_gpio)
 {
+	dp_timer_begin_phase("exit", 0u);
 	if (g5_pgmmode_flag == TRUE) {
 		opcode = G5M_ISC_DISABLE;
 		IRSCAN_in(jtag_gpio);
@@ -1322,6 +1622,7 @@ void dp_G5M_process_data(struct gpio_handle *jtag_gpio, unsigned char BlockID)
 		dp_display_value(global_uint2, DEC);
 		dp_display_text(". Please wait...\n");
 #endif
+		dp_timer_begin_phase("component", global_uint2);
 
 		opcode = G5M_FRAME_DATA;
 		IRSCAN_in(jtag_gpio);
@@ -1332,6 +1633,15 @@ void dp_G5M_process_data(struct gpio_handle *jtag_gpio, unsigned char BlockID)
 		new_progress = 0;
 #endif
 		for (global_ulong2 = 1u; global_ulong2 <= global_ulong1; global_ulong2++) {
+			if (dp_timer_expired() == TRUE) {
+				g5_current_failed_component = global_uint2;
+				g5_current_failed_block = global_ulong2;
+				global_uint2 = global_uint1;
+				break;
+			}
+#ifdef ENABLE_METRICS
+			dp_metrics_frame(global_uint2);
+#endif
 #ifdef ENABLE_DISPLAY
 			new_progress = (unsigned long)(global_ulong2 * 100 / global_ulong1);
 			if (new_progress != old_progress) {
@@ -1360,7 +1670,8 @@ void dp_G5M_process_data(struct gpio_handle *jtag_gpio, unsigned char BlockID)
 
 			if (error_code != DPE_SUCCESS) {
 				error_code = DPE_PROCESS_DATA_ERROR;
-				if (Action_code == DP_PROGRAM_ACTION_CODE)
+				if ((Action_code == DP_PROGRAM_ACTION_CODE) ||
+				    (Action_code == DP_PROGRAM_IF_DIFFERENT_ACTION_CODE))
 					unique_exit_code = 32824;
 				else if (Action_code == DP_VERIFY_ACTION_CODE)
 					unique_exit_code = 32822;
@@ -1536,7 +1847,9 @@ void dp_G5M_process_data(struct gpio_handle *jtag_gpio, unsigned char BlockID)
 			DataIndex += G5M_FRAME_BIT_LENGTH;
 		}
 #ifdef ENABLE_DISPLAY
-		if ((Action_code == DP_PROGRAM_ACTION_CODE) && g5_componenet_Supports_Cert &&
+		if (((Action_code == DP_PROGRAM_ACTION_CODE) ||
+		     (Action_code == DP_PROGRAM_IF_DIFFERENT_ACTION_CODE)) &&
+		    g5_componenet_Supports_Cert &&
 		    (error_code == DPE_SUCCESS)) {
 			dp_G5M_report_certificate(jtag_gpio);
 			if (g5_component_type == G5M_COMP_BITS)
@@ -1906,6 +2219,44 @@ void dp_G5M_display_bitstream_digest(void)
 	return;
 }
 
+/*
+ * Module: dp_G5M_get_bitstream_digest
+ * 		purpose: Copies the bitstream digest of the first BITS component of the DAT file.
+ * Return value:
+ * 		TRUE if the file has a BITS component.
+ *
+ */
+unsigned char dp_G5M_get_bitstream_digest(unsigned char *digest)
+{
+	unsigned long data_index = 0u;
+	unsigned long blocks;
+	unsigned int components;
+	unsigned int component;
+	unsigned int byte;
+
+	components =
+	    (unsigned int)dp_get_bytes(Header_ID, G5M_DATASIZE_OFFSET, G5M_DATASIZE_BYTE_LENGTH);
+	for (component = 1u; component <= components; component++) {
+		blocks = dp_get_bytes(G5M_NUMBER_OF_BLOCKS_ID,
+				      (unsigned long)(((component - 1u) * 22u) / 8u), 4u);
+		blocks >>= ((component - 1u) * 22u) % 8u;
+		blocks &= 0x3FFFFFu;
+		if ((unsigned char)dp_get_bytes(G5M_datastream_ID,
+						G5M_COMPONENT_TYPE_IN_HEADER_BYTE + data_index / 8u,
+						1u) == G5M_COMP_BITS) {
+			for (byte = 0u; byte < G5M_BSDIGEST_BYTE_SIZE; byte++) {
+				digest[byte] = (unsigned char)dp_get_bytes(
+				    G5M_datastream_ID, G5M_BSDIGEST_BYTE_OFFSET + data_index / 8u + byte,
+				    1u);
+			}
+			return TRUE;
+		}
+		data_index += G5M_FRAME_BIT_LENGTH * blocks;
+	}
+
+	return FALSE;
+}
+
 void dp_G5M_do_zeroize(struct gpio_handle *jtag_gpio, unsigned char zmode)
 {
 	unsigned char zeroize_result[16] = {0x00, 0xB6, 0x16, 0x3B, 0x25, 0xC3, 0x0A, 0xE5,
@@ -177,6 +177,7 @@ void dp_perform_G5_action(struct gpio_handle *jtag_gpio);
 void dp_G5M_device_info_action(struct gpio_handle *jtag_gpio);
 void dp_G5M_erase_action(struct gpio_handle *jtag_gpio);
 void dp_G5M_program_action(struct gpio_handle *jtag_gpio);
+void dp_G5M_program_if_different_action(struct gpio_handle *jtag_gpio);
 void dp_G5M_verify_action(struct gpio_handle *jtag_gpio);
 void dp_G5M_enc_data_authentication_action(struct gpio_handle *jtag_gpio);
 void dp_G5M_verify_digest_action(struct gpio_handle *jtag_gpio);
@@ -185,11 +186,16 @@ void dp_G5M_zeroize_like_new_action(struct gpio_handle *jtag_gpio);
 void dp_G5M_zeroize_unrecoverable_action(struct gpio_handle *jtag_gpio);
 
 void dp_check_G5_device_ID(void);
+unsigned int dp_G5M_check_device_exception(unsigned char exception, unsigned char revision);
 void dp_G5M_do_program(struct gpio_handle *jtag_gpio);
 void dp_G5M_do_verify(struct gpio_handle *jtag_gpio);
 void dp_G5M_read_udv(struct gpio_handle *jtag_gpio);
 void dp_G5M_read_design_info(struct gpio_handle *jtag_gpio);
+void dp_G5M_query_design_info(struct gpio_handle *jtag_gpio);
+void dp_G5M_query_digests(struct gpio_handle *jtag_gpio);
 void dp_G5M_read_digests(struct gpio_handle *jtag_gpio);
+void dp_G5M_record_digests(struct gpio_handle *jtag_gpio);
+void dp_G5M_record_history(struct gpio_handle *jtag_gpio);
 
 void dp_G5M_poll_device_ready(struct gpio_handle *jtag_gpio);
 void dp_G5M_check_core_status(struct gpio_handle *jtag_gpio);
@@ -198,6 +204,7 @@ void dp_G5M_read_debug_info(struct gpio_handle *jtag_gpio);
 void dp_G5M_dump_debug_info(void);
 void dp_G5M_read_tvs_monitor(struct gpio_handle *jtag_gpio);
 void dp_G5M_read_fsn(struct gpio_handle *jtag_gpio);
+void dp_G5M_query_fsn(struct gpio_handle *jtag_gpio);
 void dp_G5M_read_security(struct gpio_handle *jtag_gpio);
 void dp_G5M_query_security(struct gpio_handle *jtag_gpio);
 void dp_G5M_dump_security(void);
@@ -217,9 +224,11 @@ void dp_G5M_get_data_status(struct gpio_handle *jtag_gpio);
 void dp_G5M_report_certificate(struct gpio_handle *jtag_gpio);
 void dp_G5M_read_certificate(struct gpio_handle *jtag_gpio);
 void dp_G5M_display_bitstream_digest(void);
+unsigned char dp_G5M_get_bitstream_digest(unsigned char *digest);
 void dp_G5M_do_zeroize(struct gpio_handle *jtag_gpio, unsigned char zmode);
 void dp_G5M_do_read_zeroization_result(struct gpio_handle *jtag_gpioid);
 void dp_G5M_check_cycle_count(struct gpio_handle *jtag_gpio);
+unsigned int dp_G5M_query_cycle_count(struct gpio_handle *jtag_gpio);
 
 /* Initialization functions */
 void dp_G5M_device_poll(struct gpio_handle *jtag_gpio, unsigned char bits_to_shift, unsigned char Busy_bit);
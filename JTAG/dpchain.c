@@ -11,6 +11,7 @@
 /*                                                                          */
 /* ************************************************************************ */
 #include "dpchain.h"
+#include "dpalg.h"
 #include "dpcom.h"
 #include "dpuser.h"
 #include "dpjtag.h"
@@ -220,6 +221,11 @@ void dp_get_and_shift_in(struct gpio_handle *jtag_gpio, unsigned char Variable_I
 	terminate = 0U;
 	while (requested_bytes) {
 		page_buffer_ptr = dp_get_data(Variable_ID, start_bit_index);
+		if (return_bytes == 0U) {
+			/* The data file ends before the data block does */
+			error_code = DPE_DAT_ACCESS_FAILURE;
+			break;
+		}
 
 		if (return_bytes >= requested_bytes) {
 			return_bytes = requested_bytes;
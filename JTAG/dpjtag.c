@@ -17,6 +17,7 @@
 #include "dpuser.h"
 #include "dputil.h"
 #include "dpchain.h"
+#include "dpmetrics.h"
 
 #ifdef ENABLE_EMBEDDED_SUPPORT
 unsigned char current_jtag_state;
@@ -36,6 +37,8 @@ void IRSCAN_in(struct gpio_handle *jtag_gpio)
 	dp_shift_in(jtag_gpio, 0u, OPCODE_BIT_LENGTH, &opcode, 1u);
 	goto_jtag_state(jtag_gpio, JTAG_PAUSE_IR, 0u);
 #endif
+	DP_METRICS_ADD(ir_scans, 1u);
+	DP_METRICS_ADD(bits_shifted, OPCODE_BIT_LENGTH);
 
 	return;
 }
@@ -47,6 +50,8 @@ void IRSCAN_out(struct gpio_handle *jtag_gpio, unsigned char *outbuf)
 	dp_shift_in_out(jtag_gpio, OPCODE_BIT_LENGTH, &opcode, outbuf);
 	goto_jtag_state(jtag_gpio, JTAG_PAUSE_IR, 0u);
 #endif
+	DP_METRICS_ADD(ir_scans, 1u);
+	DP_METRICS_ADD(bits_shifted, OPCODE_BIT_LENGTH);
 
 	return;
 }
@@ -59,6 +64,8 @@ void DRSCAN_out(struct gpio_handle *jtag_gpio, unsigned int bits_to_shift, unsig
 	dp_shift_in_out(jtag_gpio, bits_to_shift, inbuf, outbuf);
 	goto_jtag_state(jtag_gpio, JTAG_PAUSE_DR, 0u);
 #endif
+	DP_METRICS_ADD(dr_scans, 1u);
+	DP_METRICS_ADD(bits_shifted, bits_to_shift);
 
 	return;
 }
@@ -71,6 +78,8 @@ void DRSCAN_in(struct gpio_handle *jtag_gpio, unsigned long start_bit_index,
 	dp_shift_in(jtag_gpio, start_bit_index, bits_to_shift, inbuf, 1u);
 	goto_jtag_state(jtag_gpio, JTAG_PAUSE_DR, 0u);
 #endif
+	DP_METRICS_ADD(dr_scans, 1u);
+	DP_METRICS_ADD(bits_shifted, bits_to_shift);
 
 	return;
 }
@@ -83,6 +92,8 @@ void dp_get_and_DRSCAN_in(struct gpio_handle *jtag_gpio, unsigned char Variable_
 	dp_get_and_shift_in(jtag_gpio, Variable_ID, total_bits_to_shift, start_bit_index);
 	goto_jtag_state(jtag_gpio, JTAG_PAUSE_DR, 0u);
 #endif
+	DP_METRICS_ADD(dr_scans, 1u);
+	DP_METRICS_ADD(bits_shifted, total_bits_to_shift);
 
 	return;
 }
@@ -97,6 +108,8 @@ void dp_get_and_DRSCAN_in_out(struct gpio_handle *jtag_gpio, unsigned char Varia
 				tdo_data);
 	goto_jtag_state(jtag_gpio, JTAG_PAUSE_DR, 0u);
 #endif
+	DP_METRICS_ADD(dr_scans, 1u);
+	DP_METRICS_ADD(bits_shifted, total_bits_to_shift);
 
 	return;
 }
@@ -353,6 +366,11 @@ void dp_get_and_shift_in(struct gpio_handle *jtag_gpio, unsigned char Variable_I
 	terminate = 0U;
 	while (requested_bytes) {
 		page_buffer_ptr = dp_get_data(Variable_ID, start_bit_index);
+		if (return_bytes == 0U) {
+			/* The data file ends before the data block does */
+			error_code = DPE_DAT_ACCESS_FAILURE;
+			break;
+		}
 		if (return_bytes >= requested_bytes) {
 			return_bytes = requested_bytes;
 			bits_to_shift = total_bits_to_shift;
@@ -19,9 +19,11 @@
 #include "dpjtag.h"
 #include "dpalg.h"
 #include "dpcom.h"
+#include "dpmetrics.h"
 #include "dpS25F.h"
 #include "dpSPIalg.h"
 #include "dpSPIprog.h"
+#include "dptimer.h"
 
 unsigned char dp_top_S25F(struct gpio_handle *jtag_gpio)
 {
@@ -114,6 +116,7 @@ void dp_S25F_program_action(struct gpio_handle *jtag_gpio)
 				old_progress = 0;
 				dp_display_text("\r\nProgramming... ");
 #endif
+				dp_timer_begin_phase("spi program", 0u);
 				DataIndex = 0;
 				do {
 					page_buffer_ptr = dp_get_data(Header_ID, DataIndex * 8u);
@@ -153,6 +156,7 @@ void dp_S25F_erase(struct gpio_handle *jtag_gpio)
 				"the entire sector will be erased. ");
 	}
 
+	dp_timer_begin_phase("spi erase", 0u);
 	address_to_process = spi_target_address;
 	number_of_sectors_to_erase =
 	    (unsigned long)((spi_target_address % sector_byte_size + image_size + sector_byte_size - 1) /
@@ -207,6 +211,7 @@ unsigned char S25F_busy_wait(struct gpio_handle *jtag_gpio)
 	unsigned char status_register;
 	unsigned long timeout = 0;
 
+	dp_timer_start_operation();
 	do {
 		status_register = S25F_read_status_register(jtag_gpio);
 		if (timeout++ > TIMEOUT_MAX_VALUE) {
@@ -214,6 +219,8 @@ unsigned char S25F_busy_wait(struct gpio_handle *jtag_gpio)
 			error_code = DPE_SPI_FLASH_TIMEOUT_ERROR;
 			break;
 		}
+		if (((status_register & 0x1) == 0x1) && (dp_timer_expired() == TRUE))
+			break;
 	} while ((status_register & 0x1) == 0x1);
 
 	return status_register;
@@ -390,6 +397,7 @@ void S25F_program_memory(struct gpio_handle *jtag_gpio, unsigned long start_addr
 			number_of_bytes -= page_bytes;
 			start_address += page_bytes;
 			bytes_processed += page_bytes;
+			DP_METRICS_ADD(spi_bytes_programmed, page_bytes);
 			processed_page_bytes += page_bytes;
 
 #ifdef ENABLE_DISPLAY
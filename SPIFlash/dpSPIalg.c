@@ -15,9 +15,12 @@
 #include "dpjtag.h"
 #include "dpalg.h"
 #include "dpcom.h"
+#include "dpimage.h"
+#include "dpmetrics.h"
 #include "dpS25F.h"
 #include "dpSPIalg.h"
 #include "dpSPIprog.h"
+#include "dptimer.h"
 
 unsigned long spi_target_address = 0;
 unsigned long long spi_flash_memory_byte_size;
@@ -107,12 +110,16 @@ void dp_SPI_read_action(struct gpio_handle *jtag_gpio)
 	unsigned long bytes_read = 0u; // This is used to keep track of how many bytes read and also used
 				 // as the starting address to read
 	unsigned long bytes_to_read = 0u;
+	unsigned long read_size = image_size;
 
 	dp_display_text("\r\nPerforming SPI Flash Read Action:\r\n");
 
-	// Image_size contains the data in ddr including header.
-	while (bytes_read < (image_size)) {
-		bytes_to_read = image_size - bytes_read;
+	// Image_size contains the data in ddr including header.  Without a DAT file the whole
+	// memory is read.
+	if (selected_image == (struct dp_image *)DPNULL)
+		read_size = (unsigned long)spi_flash_memory_byte_size;
+	while ((bytes_read < read_size) && (dp_timer_expired() == FALSE)) {
+		bytes_to_read = read_size - bytes_read;
 		if (bytes_to_read > PAGE_BUFFER_SIZE)
 			bytes_to_read = PAGE_BUFFER_SIZE;
 
@@ -137,7 +144,10 @@ void dp_SPI_verify_action(struct gpio_handle *jtag_gpio)
 		dp_display_text(" - 0x");
 		dp_display_value(spi_target_address + DataIndex + image_size - 1u, HEX);
 
+		dp_timer_begin_phase("spi verify", 0u);
 		do {
+			if (dp_timer_expired() == TRUE)
+				break;
 			page_buffer_ptr = dp_get_data(Header_ID, DataIndex * 8u);
 			if (return_bytes > image_size)
 				return_bytes = image_size;
@@ -170,6 +180,8 @@ void SPI_blank_check_memory(struct gpio_handle *jtag_gpio, unsigned long start_a
 	spi_shift_dummy_bit(jtag_gpio);
 
 	for (index = 0; index < number_of_bytes; index++) {
+		if (((index % PAGE_BUFFER_SIZE) == 0u) && (dp_timer_expired() == TRUE))
+			break;
 		spi_shift_byte_out(jtag_gpio, &data);
 		if (data != 0xffu) {
 			error_code = DPE_SPI_FLASH_BLANK_CHECK_ERROR;
@@ -249,6 +261,7 @@ void SPI_verify_memory(struct gpio_handle *jtag_gpio, unsigned long start_addres
 		}
 
 		bytes_processed++;
+		DP_METRICS_ADD(spi_bytes_verified, 1u);
 #ifdef ENABLE_DISPLAY
 		new_progress = (bytes_processed * 100u / image_size);
 		if (new_progress != old_progress) {
@@ -16,6 +16,11 @@
 #include "dpSPIalg.h"
 #include "dpSPIprog.h"
 #include "dpcom.h"
+#include "dpdatinfo.h"
+#include "dpimage.h"
+#include "dpmetrics.h"
+#include "dpreadahead.h"
+#include "dptimer.h"
 #include "dputil.h"
 
 unsigned char Action_code; /* used to hold the action codes as defined in dpalg.h */
@@ -51,14 +56,40 @@ unsigned char dp_top(struct gpio_handle *jtag_gpio)
 {
 	error_code = DPE_SUCCESS;
 	dp_init_com_vars();
+#ifdef USE_PAGING
+	page_cache_hits = 0u;
+	page_cache_misses = 0u;
+	page_cache_read_ahead = 0u;
+#endif
+#ifdef USE_READ_AHEAD
+	dp_reset_read_ahead_stats();
+#endif
+	dp_timer_start_action();
+#ifdef ENABLE_METRICS
+	dp_metrics_reset();
+#endif
+	if ((selected_image != (struct dp_image *)DPNULL) && (selected_image->load_ns != 0u)) {
+		/* Counted once, a resident image serves later actions without loading */
+		dp_timer_add_phase("load", selected_image->load_ns);
+		selected_image->load_ns = 0u;
+	}
+	dp_timer_begin_phase("identify", 0u);
 	Action_done = FALSE;
+	/* Cancelled before the action started, e.g. while the DAT file was loading */
+	if (dp_timer_expired() == TRUE)
+		Action_done = TRUE;
+	if ((Action_done == FALSE) && (Action_code == DP_DAT_INFO_ACTION_CODE)) {
+		dp_dat_info_action();
+		Action_done = TRUE;
+	}
 #ifdef ENABLE_SPI_FLASH_SUPPORT
-	if ((Action_code == DP_SPI_FLASH_READ_ID_ACTION_CODE) ||
-	    (Action_code == DP_SPI_FLASH_READ_ACTION_CODE) ||
-	    (Action_code == DP_SPI_FLASH_BLANK_CHECK_ACTION_CODE) ||
-	    (Action_code == DP_SPI_FLASH_ERASE_ACTION_CODE) ||
-	    (Action_code == DP_SPI_FLASH_PROGRAM_ACTION_CODE) ||
-	    (Action_code == DP_SPI_FLASH_VERIFY_ACTION_CODE)) {
+	if ((Action_done == FALSE) &&
+	    ((Action_code == DP_SPI_FLASH_READ_ID_ACTION_CODE) ||
+	     (Action_code == DP_SPI_FLASH_READ_ACTION_CODE) ||
+	     (Action_code == DP_SPI_FLASH_BLANK_CHECK_ACTION_CODE) ||
+	     (Action_code == DP_SPI_FLASH_ERASE_ACTION_CODE) ||
+	     (Action_code == DP_SPI_FLASH_PROGRAM_ACTION_CODE) ||
+	     (Action_code == DP_SPI_FLASH_VERIFY_ACTION_CODE))) {
 		goto_jtag_state(jtag_gpio, JTAG_TEST_LOGIC_RESET, 0u);
 		dp_read_idcode(jtag_gpio);
 		if ((device_ID & G5M_FAMILY_MASK) == (G5M_FAMILY)) {
@@ -68,6 +99,13 @@ unsigned char dp_top(struct gpio_handle *jtag_gpio)
 	}
 #endif
 
+	if ((Action_done == FALSE) && (selected_image == (struct dp_image *)DPNULL) &&
+	    (image_buffer == (unsigned char *)DPNULL)) {
+		/* No DAT file, see dp_deselect_image */
+		dp_identify_without_image(jtag_gpio);
+		Action_done = TRUE;
+	}
+
 	if (Action_done == FALSE) {
 #ifdef ENABLE_DISPLAY
 		dp_display_text("\r\nIdentifying device...");
@@ -98,9 +136,94 @@ unsigned char dp_top(struct gpio_handle *jtag_gpio)
 #endif
 		}
 	}
+
+	/* The failing operation may have replaced the code with its own error */
+	if (dp_timer_abort_code() != DPE_SUCCESS) {
+		error_code = dp_timer_abort_code();
+#ifndef ENABLE_PHASE_TIMES
+		dp_timer_display_phases();
+#endif
+	}
+#ifdef ENABLE_PHASE_TIMES
+	if (Action_code != DP_DAT_INFO_ACTION_CODE)
+		dp_timer_display_phases();
+#endif
+	dp_timer_end_phase();
+#ifdef ENABLE_METRICS
+	if ((dp_metrics_path != (signed char *)DPNULL) && (Action_code != DP_DAT_INFO_ACTION_CODE) &&
+	    (dp_metrics_write(dp_metrics_path) == FALSE)) {
+#ifdef ENABLE_DISPLAY
+		dp_display_text("\r\nWarning: failed to write the metrics to ");
+		dp_display_text(dp_metrics_path);
+#endif
+	}
+#endif
+#ifdef USE_PAGING
+	dp_display_page_cache_stats();
+#endif
+#ifdef USE_READ_AHEAD
+	dp_display_read_ahead_stats();
+#endif
 	return error_code;
 }
 
+/*
+ * Module: dp_image_required
+ * 		purpose: Tells the actions that read the DAT file from the ones that only access the
+ *		device, which also run without a file.  Zeroization needs the file so that only the
+ *		part it was built for is zeroized.  spi_flash_erase always erases the whole SPI Flash
+ *		memory, and without a file spi_flash_read reads all of it, see dp_SPI_read_action.
+ * Return value:
+ * 		TRUE if action_code needs a DAT file.
+ *
+ */
+unsigned char dp_image_required(unsigned char action_code)
+{
+	return ((action_code == DP_READ_IDCODE_ACTION_CODE) ||
+		(action_code == DP_DEVICE_INFO_ACTION_CODE) ||
+		(action_code == DP_READ_DEVICE_CERTIFICATE_ACTION_CODE) ||
+		(action_code == DP_SPI_FLASH_READ_ID_ACTION_CODE) ||
+		(action_code == DP_SPI_FLASH_READ_ACTION_CODE) ||
+		(action_code == DP_SPI_FLASH_BLANK_CHECK_ACTION_CODE) ||
+		(action_code == DP_SPI_FLASH_ERASE_ACTION_CODE))
+		   ? FALSE
+		   : TRUE;
+}
+
+/*
+ * Module: dp_identify_without_image
+ * 		purpose: Runs an action of a device found by IDCODE alone, with no DAT file to read
+ *		the family from.  A PolarFire SoC device is handled as a PolarFire device, so
+ *		device_info shows its debug information and security settings with the PolarFire
+ *		layout.
+ *
+ */
+void dp_identify_without_image(struct gpio_handle *jtag_gpio)
+{
+	if (dp_image_required(Action_code) == TRUE) {
+#ifdef ENABLE_DISPLAY
+		dp_display_text("\r\nError: Dat file is required...");
+#endif
+		error_code = DPE_DAT_ACCESS_FAILURE;
+		return;
+	}
+#ifdef ENABLE_G5_SUPPORT
+	goto_jtag_state(jtag_gpio, JTAG_TEST_LOGIC_RESET, 0u);
+	dp_read_idcode(jtag_gpio);
+	if (((device_ID & 0xfffu) == MICROSEMI_ID) &&
+	    ((device_ID & G5M_FAMILY_MASK) == G5M_FAMILY)) {
+		device_family = G5_FAMILY;
+		dp_top_g5(jtag_gpio);
+		return;
+	}
+#endif
+	error_code = DPE_IDCODE_ERROR;
+#ifdef ENABLE_DISPLAY
+	dp_display_text("\r\nError: the device is not supported without a DAT file.");
+#endif
+	return;
+}
+
 void dp_read_idcode(struct gpio_handle *jtag_gpio)
 {
 	opcode = IDCODE;
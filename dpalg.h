@@ -70,6 +70,10 @@ extern unsigned char core_is_enabled;
 #define DP_READ_DEVICE_CERTIFICATE_ACTION_CODE		    30u
 #define DP_ZEROIZE_LIKE_NEW_ACTION_CODE			    31u
 #define DP_ZEROIZE_UNRECOVERABLE_ACTION_CODE		    32u
+/* Data file only action.  No JTAG access */
+#define DP_DAT_INFO_ACTION_CODE 33u
+/* Program action that first compares the device digests with the last programming */
+#define DP_PROGRAM_IF_DIFFERENT_ACTION_CODE 34u
 
 /************************************************************/
 /* Error code definitions                                   */
@@ -123,6 +127,8 @@ extern unsigned char core_is_enabled;
 #define DPE_CODE_NOT_ENABLED	    152u
 #define CALIBRATION_OVERLAP_ERROR   153u
 #define DPE_SECURITY_BIT_MISMATCH   154u
+#define DPE_ACTION_CANCELLED	    155u
+#define DPE_TIME_BUDGET_EXCEEDED    156u
 #define DPE_DAT_VERSION_MISMATCH    160u
 #define DPE_DAT_FILE_ACCESS_ERROR   165u
 #define DPE_HARDWARE_NOT_SELECTED   170u
@@ -141,6 +147,8 @@ extern unsigned char core_is_enabled;
 
 unsigned char dp_top(struct gpio_handle *jtag_gpio);
 void dp_read_idcode(struct gpio_handle *jtag_gpio);
+unsigned char dp_image_required(unsigned char action_code);
+void dp_identify_without_image(struct gpio_handle *jtag_gpio);
 #ifdef ENABLE_DISPLAY
 void dp_read_idcode_action(void);
 #endif
@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpbatch.c                                               */
+/*                                                                          */
+/*  Description:    Batch manifest runner.  Executes a sequence of actions  */
+/*  in one invocation.  The DAT files are loaded and CRC checked once and   */
+/*  stay resident for all the steps that use them.                          */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dpbatch.h"
+
+#ifdef ENABLE_BATCH_SUPPORT
+#include "dpSPIalg.h"
+#include "dpalg.h"
+#include "dpcom.h"
+#include "dptimer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct dp_batch_step batch_steps[DP_BATCH_MAX_STEPS];
+
+/*
+ * Module: dp_run_batch
+ * 		purpose: Parses the manifest and runs its steps in order.  The batch stops at
+ *		the first failing step unless the step waits for the next board, in which case
+ *		the failure is recorded and the operator is asked for the next board.
+ * Return value:
+ * 		0 if all the steps passed, otherwise the first error code.
+ *
+ */
+int dp_run_batch(struct gpio_handle *jtag_gpio, signed char *manifest_path)
+{
+	struct dp_batch_step *step;
+	struct dp_image *image;
+	unsigned int step_count;
+	unsigned int step_index;
+	unsigned int image_count = 0u;
+	unsigned int index;
+	unsigned int run;
+	unsigned char status = DPE_SUCCESS;
+	unsigned char iExecResult;
+	unsigned char stop = FALSE;
+	unsigned long start_time;
+	long elapsed_ms;
+
+	step_count = dp_batch_parse_manifest(manifest_path, batch_steps, &status);
+	if (status != DPE_SUCCESS)
+		return status;
+
+	/* Keep every DAT file of the manifest resident, so each is loaded and checked once */
+	for (step_index = 0u; step_index < step_count; step_index++) {
+		for (index = 0u; index < step_index; index++) {
+			if (strcmp((char *)batch_steps[index].path,
+				   (char *)batch_steps[step_index].path) == 0)
+				break;
+		}
+		if (index == step_index)
+			image_count++;
+	}
+	if (dp_reserve_resident_images(image_count) == FALSE) {
+		printf("Error: can't allocate memory for %u dat files\n", image_count);
+		return DP_IMAGE_MEMORY_ERROR;
+	}
+
+	for (step_index = 0u; (step_index < step_count) && (stop == FALSE); step_index++) {
+		step = &batch_steps[step_index];
+		for (run = 0u; (run < step->repeat) && (stop == FALSE); run++) {
+			if ((step->wait_for_board == TRUE) && (dp_batch_wait_for_board() == FALSE)) {
+				stop = TRUE;
+				break;
+			}
+			printf("\r\n===== Step %u/%u run %u/%u: %s %s =====", step_index + 1u,
+			       step_count, run + 1u, step->repeat, step->action, step->path);
+			fflush(stdout);
+
+			start_time = dp_timer_ms();
+			image = dp_get_resident_image(step->path, &iExecResult);
+			if (image != (struct dp_image *)DPNULL) {
+				dp_select_image(image);
+				Action_code = step->action_code;
+#ifdef ENABLE_SPI_FLASH_SUPPORT
+				spi_target_address = step->spi_address;
+#endif
+				iExecResult = dp_top(jtag_gpio);
+			}
+			elapsed_ms = (long)(dp_timer_ms() - start_time);
+
+			step->runs++;
+			step->elapsed_ms += elapsed_ms;
+			step->last_error = iExecResult;
+			if (iExecResult == DPE_SUCCESS) {
+				step->passed++;
+				printf("\r\nStep %u passed in %ld ms\n", step_index + 1u, elapsed_ms);
+			} else {
+				printf("\r\nStep %u failed with error code %u after %ld ms\n",
+				       step_index + 1u, iExecResult, elapsed_ms);
+				if (status == DPE_SUCCESS)
+					status = iExecResult;
+				if (step->wait_for_board == FALSE)
+					stop = TRUE;
+			}
+		}
+	}
+
+	dp_batch_display_summary(batch_steps, step_count);
+	dp_release_resident_images();
+	return status;
+}
+
+/*
+ * Module: dp_batch_parse_manifest
+ * 		purpose: Reads all the steps of the manifest so that syntax errors are reported
+ *		before any board is touched.
+ * Return value:
+ * 		Number of steps.  status is set to DP_BATCH_MANIFEST_ERROR on failure.
+ *
+ */
+unsigned int dp_batch_parse_manifest(signed char *manifest_path, struct dp_batch_step *steps,
+				     unsigned char *status)
+{
+	FILE *fp;
+	char line[DP_BATCH_LINE_SIZE];
+	char *token;
+	char *end;
+	unsigned int line_number = 0u;
+	unsigned int step_count = 0u;
+	struct dp_batch_step *step;
+
+	fp = fopen((char *)manifest_path, "r");
+	if (fp == (FILE *)DPNULL) {
+		printf("Error: can't open manifest %s\n", manifest_path);
+		*status = DP_BATCH_MANIFEST_ERROR;
+		return 0u;
+	}
+
+	while ((*status == DPE_SUCCESS) && (fgets(line, sizeof(line), fp) != (char *)DPNULL)) {
+		line_number++;
+		token = strtok(line, " \t\r\n");
+		if ((token == (char *)DPNULL) || (token[0] == '#'))
+			continue;
+		if (step_count == DP_BATCH_MAX_STEPS) {
+			printf("Error: manifest line %u: more than %u steps\n", line_number,
+			       DP_BATCH_MAX_STEPS);
+			*status = DP_BATCH_MANIFEST_ERROR;
+			break;
+		}
+
+		step = &steps[step_count];
+		memset(step, 0, sizeof(struct dp_batch_step));
+		step->repeat = 1u;
+		strncpy((char *)step->action, token, DP_BATCH_ACTION_SIZE - 1u);
+		step->action_code = dp_get_Action_code(step->action);
+		if (step->action_code == DP_NO_ACTION_FOUND) {
+			printf("Error: manifest line %u: invalid action %s\n", line_number, token);
+			*status = DP_BATCH_MANIFEST_ERROR;
+			break;
+		}
+
+		token = strtok((char *)DPNULL, " \t\r\n");
+		if (token == (char *)DPNULL) {
+			printf("Error: manifest line %u: dat file is required\n", line_number);
+			*status = DP_BATCH_MANIFEST_ERROR;
+			break;
+		}
+		strncpy((char *)step->path, token, DP_IMAGE_PATH_SIZE - 1u);
+
+		while ((token = strtok((char *)DPNULL, " \t\r\n")) != (char *)DPNULL) {
+#ifdef ENABLE_SPI_FLASH_SUPPORT
+			if (strncmp(token, "address=", 8) == 0) {
+				step->spi_address = strtoul(&token[8], (char **)DPNULL, 0);
+			} else
+#endif
+			if (strncmp(token, "repeat=", 7) == 0) {
+				step->repeat = 0u;
+				if ((token[7] >= '0') && (token[7] <= '9'))
+					step->repeat = (unsigned int)strtoul(&token[7], &end, 0);
+				if ((step->repeat == 0u) || (*end != '\0')) {
+					printf("Error: manifest line %u: invalid repeat count %s\n",
+					       line_number, &token[7]);
+					*status = DP_BATCH_MANIFEST_ERROR;
+					break;
+				}
+			} else if (strcmp(token, "wait") == 0) {
+				step->wait_for_board = TRUE;
+			} else {
+				printf("Error: manifest line %u: invalid option %s\n", line_number,
+				       token);
+				*status = DP_BATCH_MANIFEST_ERROR;
+				break;
+			}
+		}
+		step_count++;
+	}
+	fclose(fp);
+
+	return step_count;
+}
+
+/*
+ * Module: dp_batch_wait_for_board
+ * 		purpose: Asks the operator to connect the next board.
+ * Return value:
+ * 		FALSE if the operator ended the batch (end of input or 'q').
+ *
+ */
+unsigned char dp_batch_wait_for_board(void)
+{
+	char answer[16];
+
+	printf("\r\nConnect the next board and press Enter ('q' to stop): ");
+	fflush(stdout);
+	if ((fgets(answer, sizeof(answer), stdin) == (char *)DPNULL) ||
+	    (answer[0] == 'q') || (answer[0] == 'Q'))
+		return FALSE;
+	return TRUE;
+}
+
+void dp_batch_display_summary(struct dp_batch_step *steps, unsigned int step_count)
+{
+	unsigned int index;
+
+	printf("\r\n\r\nBatch summary:\n");
+	printf("%-5s %-24s %-6s %-6s %-12s %-12s %s\n", "Step", "Action", "Runs", "Passed",
+	       "Total (ms)", "Average (ms)", "Dat file");
+	for (index = 0u; index < step_count; index++) {
+		printf("%-5u %-24s %-6u %-6u %-12ld %-12ld %s\n", index + 1u, steps[index].action,
+		       steps[index].runs, steps[index].passed, steps[index].elapsed_ms,
+		       (steps[index].runs != 0u) ? steps[index].elapsed_ms / steps[index].runs : 0L,
+		       steps[index].path);
+	}
+	fflush(stdout);
+	return;
+}
+#endif /* ENABLE_BATCH_SUPPORT */
+
+/*   *************** End of File *************** */
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpbatch.h                                               */
+/*                                                                          */
+/*  Description:    Contains function prototypes of the batch manifest     */
+/*  runner                                                                  */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPBATCH_H
+#define INC_DPBATCH_H
+
+#include "dpuser.h"
+
+#ifdef ENABLE_BATCH_SUPPORT
+#include "dpimage.h"
+
+/*
+ * Manifest format, one step per line.  Empty lines and lines starting with '#'
+ * are ignored:
+ *	<action> <dat file> [address=<spi target address>] [repeat=<count>] [wait]
+ * "wait" asks the operator to connect the next board before every run of the step.
+ */
+#define DP_BATCH_MAX_STEPS   64u
+#define DP_BATCH_LINE_SIZE   512u
+#define DP_BATCH_ACTION_SIZE 32u
+
+#define DP_BATCH_MANIFEST_ERROR 108u
+
+struct dp_batch_step {
+	signed char action[DP_BATCH_ACTION_SIZE];
+	signed char path[DP_IMAGE_PATH_SIZE];
+	unsigned char action_code;
+#ifdef ENABLE_SPI_FLASH_SUPPORT
+	unsigned long spi_address;
+#endif
+	unsigned int repeat;
+	unsigned char wait_for_board;
+	unsigned int runs;
+	unsigned int passed;
+	unsigned char last_error;
+	long elapsed_ms;
+};
+
+int dp_run_batch(struct gpio_handle *jtag_gpio, signed char *manifest_path);
+unsigned int dp_batch_parse_manifest(signed char *manifest_path, struct dp_batch_step *steps,
+				     unsigned char *status);
+unsigned char dp_batch_wait_for_board(void);
+void dp_batch_display_summary(struct dp_batch_step *steps, unsigned int step_count);
+#endif
+
+#endif /* INC_DPBATCH_H */
+
+/*   *************** End of File *************** */
@@ -0,0 +1,208 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpbundle.c                                              */
+/*                                                                          */
+/*  Description:    Image bundles.  A bundle is a directory holding the DAT */
+/*  files built for different parts.  IDCODE is read first, then only the   */
+/*  headers of the files are read to find the one built for the connected   */
+/*  device, so only that file is loaded and CRC checked.                    */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dpbundle.h"
+#include "dpG5alg.h"
+#include "dpalg.h"
+#include "dpimage.h"
+#include "dpjtag.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static unsigned long dp_bundle_field(unsigned char *header, unsigned int offset,
+				     unsigned int bytes)
+{
+	unsigned long value = 0u;
+
+	while (bytes) {
+		bytes--;
+		value = (value << 8u) | (unsigned long)header[offset + bytes];
+	}
+	return value;
+}
+
+/*
+ * Module: dp_bundle_read_header
+ * 		purpose: Reads the header of a file of the bundle.
+ * Return value:
+ * 		TRUE if the file is a regular file that starts with a DAT file signature.
+ *
+ */
+static unsigned char dp_bundle_read_header(char *path, unsigned char *header)
+{
+	struct stat file_stat;
+	unsigned long signature;
+	ssize_t received;
+	int fd;
+
+	if ((stat(path, &file_stat) != 0) || (!S_ISREG(file_stat.st_mode)))
+		return FALSE;
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return FALSE;
+	received = read(fd, header, DP_BUNDLE_HEADER_SIZE);
+	close(fd);
+	if (received != (ssize_t)DP_BUNDLE_HEADER_SIZE)
+		return FALSE;
+
+	signature = dp_bundle_field(header, 0u, 4u);
+	return ((signature == 0x69736544u) || (signature == 0x65746341u) ||
+		(signature == 0x2D4D3447u) || (signature == 0x34475452u) ||
+		(signature == 0x2D4D3547u))
+		   ? TRUE
+		   : FALSE;
+}
+
+/*
+ * Module: dp_bundle_header_matches
+ * 		purpose: Applies the checks of dp_check_G5_device_ID to a header: the masked ID
+ *		must match the masked IDCODE, and the device exception must suit the revision.
+ *		Without ENABLE_G5_SUPPORT no file can be programmed, so none matches.
+ * Return value:
+ * 		TRUE if the file was built for the device.
+ *
+ */
+static unsigned char dp_bundle_header_matches(unsigned char *header, unsigned long idcode,
+					      unsigned char revision)
+{
+#ifdef ENABLE_G5_SUPPORT
+	unsigned long file_ID;
+	unsigned long file_mask;
+
+	if (header[G5M_DEVICE_FAMILY_OFFSET] != G5M_FAMILY_ID_IN_DAT)
+		return FALSE;
+	file_ID = dp_bundle_field(header, G5M_ID_OFFSET, G5M_ID_BYTE_LENGTH);
+	file_mask = dp_bundle_field(header, G5M_ID_MASK_OFFSET, G5M_ID_MASK_BYTE_LENGTH);
+	if ((((file_ID & file_mask) & 0xfffu) != MICROSEMI_ID) ||
+	    ((idcode & file_mask) != (file_ID & file_mask)))
+		return FALSE;
+	return (dp_G5M_check_device_exception(header[G5M_DEVICE_EXCEPTION_OFFSET], revision) == 0u)
+		   ? TRUE
+		   : FALSE;
+#else
+	(void)header;
+	(void)idcode;
+	(void)revision;
+	return FALSE;
+#endif
+}
+
+/*
+ * Module: dp_is_image_bundle
+ * 		purpose: Tells a bundle directory from a DAT file.
+ * Return value:
+ * 		TRUE if path is a directory.
+ *
+ */
+unsigned char dp_is_image_bundle(signed char *path)
+{
+	struct stat file_stat;
+
+	return ((stat((char *)path, &file_stat) == 0) && S_ISDIR(file_stat.st_mode)) ? TRUE : FALSE;
+}
+
+/*
+ * Module: dp_find_bundle_image
+ * 		purpose: Looks for the file of the bundle directory that was built for the device
+ *		with the given IDCODE and revision and copies its path to path, which holds
+ *		DP_IMAGE_PATH_SIZE bytes.  Hidden files, sidecar files and files that are not
+ *		uncompressed DAT files are skipped.
+ * Return value:
+ * 		DP_IMAGE_LOADED if exactly one file matches, DP_IMAGE_NO_MATCH, DP_IMAGE_AMBIGUOUS or
+ *		DP_IMAGE_OPEN_ERROR.
+ *
+ */
+unsigned char dp_find_bundle_image(signed char *directory, unsigned long idcode,
+				   unsigned char revision, signed char *path)
+{
+	DIR *bundle;
+	struct dirent *entry;
+	char candidate[DP_IMAGE_PATH_SIZE];
+	unsigned char header[DP_BUNDLE_HEADER_SIZE];
+	unsigned int matches = 0u;
+	size_t name_length;
+	int length;
+
+	bundle = opendir((char *)directory);
+	if (bundle == (DIR *)DPNULL) {
+#ifdef ENABLE_DISPLAY
+		dp_display_text("\r\nError: can't open bundle directory \n");
+		dp_display_text(directory);
+#endif
+		return DP_IMAGE_OPEN_ERROR;
+	}
+	while ((entry = readdir(bundle)) != (struct dirent *)DPNULL) {
+		name_length = strlen(entry->d_name);
+		if ((entry->d_name[0] == '.') ||
+		    ((name_length >= sizeof(DP_IMAGE_CACHE_SUFFIX) - 1u) &&
+		     (strcmp(&entry->d_name[name_length - (sizeof(DP_IMAGE_CACHE_SUFFIX) - 1u)],
+			     DP_IMAGE_CACHE_SUFFIX) == 0)))
+			continue;
+		length = snprintf(candidate, sizeof(candidate), "%s/%s", (char *)directory,
+				  entry->d_name);
+		if ((length < 0) || ((size_t)length >= sizeof(candidate)))
+			continue;
+		if ((dp_bundle_read_header(candidate, header) == FALSE) ||
+		    (dp_bundle_header_matches(header, idcode, revision) == FALSE))
+			continue;
+
+		matches++;
+#ifdef ENABLE_DISPLAY
+		dp_display_text("\r\nMatching file: ");
+		dp_display_text((signed char *)candidate);
+#endif
+		if (matches == 1u)
+			strcpy((char *)path, candidate);
+	}
+	closedir(bundle);
+
+	if (matches == 0u) {
+#ifdef ENABLE_DISPLAY
+		dp_display_text("\r\nError: no file of the bundle was built for IDCODE ");
+		dp_display_value(idcode, HEX);
+#endif
+		return DP_IMAGE_NO_MATCH;
+	}
+	if (matches > 1u) {
+#ifdef ENABLE_DISPLAY
+		dp_display_text("\r\nError: more than one file of the bundle matches the device");
+#endif
+		return DP_IMAGE_AMBIGUOUS;
+	}
+	return DP_IMAGE_LOADED;
+}
+
+/*
+ * Module: dp_resolve_bundle
+ * 		purpose: Reads IDCODE from the connected device and looks for its file in the
+ *		bundle directory with dp_find_bundle_image.
+ * Return value:
+ * 		See dp_find_bundle_image.
+ *
+ */
+unsigned char dp_resolve_bundle(struct gpio_handle *jtag_gpio, signed char *directory,
+				signed char *path)
+{
+	goto_jtag_state(jtag_gpio, JTAG_TEST_LOGIC_RESET, 0u);
+	dp_read_idcode(jtag_gpio);
+	return dp_find_bundle_image(directory, device_ID, device_rev, path);
+}
+
+/*   *************** End of File *************** */
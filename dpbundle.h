@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpbundle.h                                              */
+/*                                                                          */
+/*  Description:    Contains function prototypes to pick the DAT file that  */
+/*  matches the connected device out of a directory of variants             */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPBUNDLE_H
+#define INC_DPBUNDLE_H
+
+#include "dpuser.h"
+
+/* Bytes read from each file of a bundle: the G5 header up to the device exception byte */
+#define DP_BUNDLE_HEADER_SIZE 70u
+
+unsigned char dp_is_image_bundle(signed char *path);
+unsigned char dp_find_bundle_image(signed char *directory, unsigned long idcode,
+				   unsigned char revision, signed char *path);
+unsigned char dp_resolve_bundle(struct gpio_handle *jtag_gpio, signed char *directory,
+				signed char *path);
+
+#endif /* INC_DPBUNDLE_H */
+
+/*   *************** End of File *************** */
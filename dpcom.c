@@ -13,6 +13,14 @@
 /* ************************************************************************ */
 #include "dpcom.h"
 #include "dpuser.h"
+#include "dpalg.h"
+
+#include "dpreadahead.h"
+
+#ifdef USE_PAGING
+#include <string.h>
+#include <unistd.h>
+#endif
 
 /*
  * Paging System Specific Implementation.  User attention required:
@@ -23,8 +31,13 @@ unsigned char page_global_buffer[PAGE_BUFFER_SIZE]; /* Page_global_buffer simula
 						 that is accessible by DirectC code*/
 #ifdef USE_PAGING
 unsigned long page_address_offset;
-unsigned long start_page_address = 0u;
-unsigned long end_page_address = 0u;
+/* File holding the image, or -1 to page from image_buffer */
+int image_fd = -1;
+struct dp_page page_cache[PAGE_CACHE_ENTRIES];
+unsigned long page_cache_clock = 0u;
+unsigned long page_cache_hits = 0u;
+unsigned long page_cache_misses = 0u;
+unsigned long page_cache_read_ahead = 0u; /* Misses served by the read-ahead thread */
 #endif
 
 unsigned long return_bytes;
@@ -34,21 +47,37 @@ unsigned long requested_bytes;
  * global_buf1fer data is currently holding
  */
 unsigned long current_block_address = 0U;
-unsigned char current_var_ID = Header_ID;
+/* Number of bytes of the data block that starts at current_block_address */
+unsigned long current_block_length = 0U;
+/* Address and length of every data block, indexed by block ID.  Parsed from the lookup
+ * table once per selected image. */
+struct dp_block block_directory[DP_BLOCK_DIRECTORY_SIZE];
+unsigned char block_directory_valid = FALSE;
 unsigned long image_size = MIN_IMAGE_SIZE;
 
 /*
  * Module: dp_init_com_vars(void)
  * 		purpose: This function is called at the begining to initialize starting and ending
- *page addresses. Arguments: None. Return value: None.
+ *page addresses and to forget the data block address of a previously selected image.
+ *Arguments: None. Return value: None.
  *
  */
 void dp_init_com_vars(void)
 {
 #ifdef USE_PAGING
-	start_page_address = 0u;
-	end_page_address = 0u;
+	unsigned int index;
+
+	for (index = 0u; index < PAGE_CACHE_ENTRIES; index++) {
+		page_cache[index].length = 0u;
+	}
+	page_address_offset = 0u;
 #endif
+#ifdef USE_READ_AHEAD
+	dp_read_ahead_invalidate();
+#endif
+	current_block_address = 0U;
+	current_block_length = 0U;
+	block_directory_valid = FALSE;
 	return;
 }
 
@@ -60,17 +89,23 @@ void dp_init_com_vars(void)
  *an unsigned integer variable contains an identifier specifying which block address to return.
  *		unsigned long bit_index: The bit location of the first bit to be processed (clocked in)
  *within the data block specified by Var_ID. Return value: Address point to the first element in the
- *block.
+ *block.  return_bytes never extends past the end of the block, and is 0 if the block is missing
+ *or bit_index is outside of it.
  *
  */
 unsigned char *dp_get_data(unsigned char var_ID, unsigned long bit_index)
 {
 	unsigned char *data_address = (unsigned char *)DPNULL;
+	unsigned long byte_index = bit_index / 8U;
+
 	dp_get_data_block_address(var_ID);
-	if ((current_block_address == 0U) && (var_ID != Header_ID)) {
+	if (byte_index >= current_block_length) {
 		return_bytes = 0U;
 	} else {
 		data_address = dp_get_data_block_element_address(bit_index);
+		if (return_bytes > current_block_length - byte_index) {
+			return_bytes = current_block_length - byte_index;
+		}
 	}
 	return data_address;
 }
@@ -97,81 +132,184 @@ unsigned char *dp_get_header_data(unsigned long bit_index)
 /*
  * User attention:
  * Module: dp_get_page_data
- * 		purpose: This function is called by dp_get_data function.  This is done every time a
- *new data block is needed or when requested data is not in the current page.  This function expects
- *the location of the first byte to return and will fill the entire page with valid data. Arguments:
+ * 		purpose: This function is called by dp_get_data function when the requested data
+ *is not in any of the cached pages.  The least recently used page is refilled starting at the
+ *first byte to return.  Arguments:
  *		unsigned long image_requested_address, a ulong variable containing the relative address
- *location of the first needed byte Return value: None.
+ *location of the first needed byte Return value: The refilled page.
  *
  */
 #ifdef USE_PAGING
-void dp_get_page_data(unsigned long image_requested_address)
+struct dp_page *dp_get_page_data(unsigned long image_requested_address)
 {
-#ifdef ENABLE_EMBEDDED_SUPPORT
-	return_bytes = PAGE_BUFFER_SIZE;
+	struct dp_page *page = &page_cache[0];
+	unsigned int index;
+	ssize_t received;
+	unsigned long length = 0u;
+
+	for (index = 1u; index < PAGE_CACHE_ENTRIES; index++) {
+		if (page_cache[index].last_used < page->last_used)
+			page = &page_cache[index];
+	}
+
+#ifdef USE_READ_AHEAD
+	if ((image_fd >= 0) && (dp_read_ahead_get(image_requested_address, page) == TRUE)) {
+		page_cache_read_ahead++;
+		return page;
+	}
+#endif
+	page->start_address = image_requested_address;
+	page->length = PAGE_CACHE_PAGE_SIZE;
 	/* Image size will initially be the header size which is part of the image file.
 	 * This must be done to avoid accessing data that is outside the image boundaries in case
-	 * the page_global_buffer size is greater than the image itself image_size variable will be
+	 * the page size is greater than the image itself image_size variable will be
 	 * read from the image file at a later time.
 	 */
 
 	/* This is needed to avoid out of bound memory access*/
-	if (image_requested_address + return_bytes > image_size) {
-		return_bytes = image_size - image_requested_address;
+	if (image_requested_address >= image_size) {
+		page->length = 0u;
+	} else if (image_requested_address + page->length > image_size) {
+		page->length = image_size - image_requested_address;
 	}
 
-	/*
-	 *  Add a funciton call here to get the page data from the external storage device.
-	 */
+#ifdef ENABLE_EMBEDDED_SUPPORT
+	if (image_fd < 0) {
+		memcpy(page->data, &image_buffer[image_requested_address], page->length);
+		length = page->length;
+	} else {
+		while (length < page->length) {
+			received = pread(image_fd, &page->data[length], page->length - length,
+					 (off_t)(image_requested_address + length));
+			if (received <= 0)
+				break;
+			length += (unsigned long)received;
+		}
+	}
+#endif
+	if (length < page->length) {
+		/* Keep the callers' loops bounded.  The action fails on error_code. */
+		memset(&page->data[length], 0, page->length - length);
+		if (error_code != DPE_DAT_ACCESS_FAILURE) {
+#ifdef ENABLE_DISPLAY
+			dp_display_text("\r\nError: failed to read the image at offset ");
+			dp_display_value(image_requested_address + length, DEC);
+#endif
+			error_code = DPE_DAT_ACCESS_FAILURE;
+		}
+	}
+#ifdef USE_READ_AHEAD
+	if (image_fd >= 0)
+		dp_read_ahead_note_miss(image_fd, image_requested_address, page->length);
+#endif
+	page_cache_misses++;
+	return page;
+}
 
+void dp_display_page_cache_stats(void)
+{
+#ifdef ENABLE_DISPLAY
+	dp_display_text("\r\nPage cache hits: ");
+	dp_display_value(page_cache_hits, DEC);
+	dp_display_text(" misses: ");
+	dp_display_value(page_cache_misses, DEC);
+#ifdef USE_READ_AHEAD
+	dp_display_text(" read ahead: ");
+	dp_display_value(page_cache_read_ahead, DEC);
+#endif
 #endif
 	return;
 }
 #endif
 
 /*
- * Module: dp_get_data_block_address
- * 		purpose: This function sets current_block_address to the first relative address of
- * the requested data block within the data file. Return value: None.
+ * Module: dp_parse_block_directory
+ * 		purpose: This function reads the lookup table at the end of the header into
+ *block_directory.  Records that point outside of the image are ignored, and a block length that
+ *is missing or runs past the end of the image is cut at the end of the image.  The first record
+ *of a block ID is used.  Return value: None.
  */
-void dp_get_data_block_address(unsigned char requested_var_ID)
+void dp_parse_block_directory(void)
 {
 	unsigned int var_idx;
 	unsigned long image_index;
+	unsigned long record;
+	unsigned long block_address;
+	unsigned long block_length;
 	unsigned int num_vars;
 	unsigned char variable_ID;
 
-	/* If the current data block ID is the same as the requested one, there is no need to
-	 * caluclate its starting address. it is already calculated.
-	 */
-	if (current_var_ID != requested_var_ID) {
+	for (var_idx = 0U; var_idx < DP_BLOCK_DIRECTORY_SIZE; var_idx++) {
+		block_directory[var_idx].length = 0U;
+	}
+	block_directory_valid = TRUE;
+
+	/*The lookup table is at the end of the header*/
+	image_index = dp_get_header_bytes((HEADER_SIZE_OFFSET), 1U);
+	image_size = dp_get_header_bytes(IMAGE_SIZE_OFFSET, 4U);
+
+	if ((image_index == 0U) || (image_index > image_size)) {
+		return;
+	}
+
+	/* The last byte in the header is the number of data blocks in the dat file */
+	num_vars = (unsigned int)dp_get_header_bytes(image_index - 1U, 1U);
+
+	for (var_idx = 0U; var_idx < num_vars; var_idx++) {
+		record = image_index + BTYES_PER_TABLE_RECORD * var_idx;
+		if (record + BTYES_PER_TABLE_RECORD > image_size) {
+			break;
+		}
+		variable_ID = (unsigned char)dp_get_header_bytes(record, 1U);
+		block_address = dp_get_header_bytes(record + 1U, 4U);
+		block_length = dp_get_header_bytes(record + 5U, 4U);
+		if ((variable_ID == Header_ID) || (block_directory[variable_ID].length != 0U) ||
+		    (block_address >= image_size)) {
+			continue;
+		}
+		if ((block_length == 0U) || (block_length > image_size - block_address)) {
+			block_length = image_size - block_address;
+		}
+		block_directory[variable_ID].address = block_address;
+		block_directory[variable_ID].length = block_length;
+	}
+	return;
+}
+
+/*
+ * Module: dp_get_data_block_address
+ * 		purpose: This function sets current_block_address and current_block_length to the
+ * location of the requested data block within the data file.  Both are 0 if the image has no such
+ * block.  Return value: None.
+ */
+void dp_get_data_block_address(unsigned char requested_var_ID)
+{
+	if (requested_var_ID == Header_ID) {
+		/* The header is addressed as a block spanning the whole image */
 		current_block_address = 0U;
-		current_var_ID = Header_ID;
-		if (requested_var_ID != Header_ID) {
-			/*The lookup table is at the end of the header*/
-			image_index = dp_get_header_bytes((HEADER_SIZE_OFFSET), 1U);
-			image_size = dp_get_header_bytes(IMAGE_SIZE_OFFSET, 4U);
-
-			/* The last byte in the header is the number of data blocks in the dat file
-			 */
-			num_vars = (unsigned int)dp_get_header_bytes(image_index - 1U, 1U);
-
-			for (var_idx = 0U; var_idx < num_vars; var_idx++) {
-				variable_ID = (unsigned char)dp_get_header_bytes(
-				    image_index + BTYES_PER_TABLE_RECORD * var_idx, 1U);
-				if (variable_ID == requested_var_ID) {
-					current_block_address = dp_get_header_bytes(
-					    image_index + BTYES_PER_TABLE_RECORD * var_idx + 1U,
-					    4U);
-					current_var_ID = variable_ID;
-					break;
-				}
-			}
+		current_block_length = image_size;
+	} else {
+		if (block_directory_valid == FALSE) {
+			dp_parse_block_directory();
 		}
+		current_block_address = block_directory[requested_var_ID].address;
+		current_block_length = block_directory[requested_var_ID].length;
 	}
 	return;
 }
 
+/*
+ * Module: dp_get_block_length
+ * 		purpose: This function returns the length of the data block var_ID as read from the
+ *lookup table, cut at the end of the image.  Return value: The length in bytes, 0 if the image
+ *has no such block.
+ */
+unsigned long dp_get_block_length(unsigned char var_ID)
+{
+	dp_get_data_block_address(var_ID);
+	return current_block_length;
+}
+
 /*
  * Module: dp_get_data_block_element_address
  * 		purpose: This function return unsigned char pointer of the byte containing bit_index
@@ -182,26 +320,38 @@ void dp_get_data_block_address(unsigned char requested_var_ID)
 unsigned char *dp_get_data_block_element_address(unsigned long bit_index)
 {
 	unsigned long image_requested_address;
+#ifdef USE_PAGING
+	struct dp_page *page;
+	unsigned int index;
+#endif
 	/* Calculating the relative address of the data block needed within the image */
 	image_requested_address = current_block_address + bit_index / 8U;
 
 #ifdef USE_PAGING
-	/* If the data is within the page, adjust the pointer to point to the particular element
-	 * requested */
-	/* For first load, start_page_address = end_page_address = 0u */
-	if ((start_page_address != end_page_address) &&
-	    (image_requested_address >= start_page_address) &&
-	    (image_requested_address <= end_page_address) &&
-	    ((image_requested_address + MIN_VALID_BYTES_IN_PAGE) <= end_page_address)) {
-		page_address_offset = image_requested_address - start_page_address;
-		return_bytes = end_page_address - image_requested_address + 1u;
+	/* Use a cached page if it holds at least MIN_VALID_BYTES_IN_PAGE bytes starting at the
+	 * requested address, or everything up to the end of the image */
+	page = (struct dp_page *)DPNULL;
+	for (index = 0u; index < PAGE_CACHE_ENTRIES; index++) {
+		if ((page_cache[index].length != 0u) &&
+		    (image_requested_address >= page_cache[index].start_address) &&
+		    ((image_requested_address + MIN_VALID_BYTES_IN_PAGE <=
+		      page_cache[index].start_address + page_cache[index].length) ||
+		     (page_cache[index].start_address + page_cache[index].length == image_size))) {
+			page = &page_cache[index];
+			break;
+		}
 	}
-	/* Otherwise, call dp_get_page_data which would fill the page with a new data block */
+	if (page != (struct dp_page *)DPNULL) {
+		page_cache_hits++;
+	}
+	/* Otherwise, call dp_get_page_data which would fill a page with a new data block */
 	else {
-		dp_get_page_data(image_requested_address);
-		page_address_offset = 0u;
+		page = dp_get_page_data(image_requested_address);
 	}
-	return &page_global_buffer[page_address_offset];
+	page->last_used = ++page_cache_clock;
+	page_address_offset = image_requested_address - page->start_address;
+	return_bytes = (page_address_offset < page->length) ? page->length - page_address_offset : 0u;
+	return &page->data[page_address_offset];
 #else
 	return_bytes = image_size - image_requested_address;
 	/*
@@ -213,6 +363,65 @@ unsigned char *dp_get_data_block_element_address(unsigned long bit_index)
 #endif
 }
 
+/*
+ * Module: dp_image_resident
+ * 		purpose: This function tells whether image_buffer holds the whole image so that
+ *fields can be read from it directly.  Return value: TRUE or FALSE.
+ */
+static unsigned char dp_image_resident(void)
+{
+#ifdef USE_PAGING
+	return (unsigned char)((image_fd < 0) && (image_buffer != (unsigned char *)DPNULL));
+#else
+	return TRUE;
+#endif
+}
+
+/*
+ * Module: dp_load_le
+ * 		purpose: This function combines 1 to 4 bytes stored least significant byte first.
+ * Return value:
+ * 		unsigned long:  The combined value.
+ */
+static unsigned long dp_load_le(const unsigned char *data, unsigned char bytes)
+{
+	unsigned long ret = 0U;
+
+	switch (bytes) {
+	case 4u:
+		ret = ((unsigned long)data[3] << 24U) | ((unsigned long)data[2] << 16U);
+		/* fall through */
+	case 2u:
+		ret |= (unsigned long)data[1] << 8U;
+		/* fall through */
+	case 1u:
+		ret |= (unsigned long)data[0];
+		break;
+	default:
+		while (bytes) {
+			bytes--;
+			ret = (ret << 8U) | (unsigned long)data[bytes];
+		}
+		break;
+	}
+	return ret;
+}
+
+/*
+ * Module: dp_get_block_span
+ * 		purpose: This function returns a pointer to byte byte_index of the data block var_ID
+ *and sets span_bytes to the number of bytes that can be read through it: the rest of the block when
+ *the image is in memory, or the rest of the page when paging.  The pointer is valid until the image
+ *is accessed again.  Return value: The pointer, with span_bytes set to 0 if there is no such data.
+ */
+unsigned char *dp_get_block_span(unsigned char var_ID, unsigned long byte_index, unsigned long *span_bytes)
+{
+	unsigned char *data_address = dp_get_data(var_ID, byte_index * 8U);
+
+	*span_bytes = return_bytes;
+	return data_address;
+}
+
 /*
  * Module: dp_get_bytes
  * 		purpose: This function is designed to return all the requested bytes specified.
@@ -231,6 +440,17 @@ unsigned long dp_get_bytes(unsigned char var_ID, unsigned long byte_index, unsig
 	unsigned char j;
 	j = 0U;
 
+	/* Read the field directly when the image is in memory and the field is inside the block */
+	if ((bytes_requested != 0U) && (dp_image_resident() == TRUE)) {
+		dp_get_data_block_address(var_ID);
+		if ((byte_index < current_block_length) &&
+		    ((unsigned long)bytes_requested <= current_block_length - byte_index)) {
+			page_buffer_ptr = &image_buffer[current_block_address + byte_index];
+			return_bytes = (unsigned long)bytes_requested;
+			return dp_load_le(page_buffer_ptr, bytes_requested);
+		}
+	}
+
 	while (bytes_requested) {
 		page_buffer_ptr = dp_get_data(var_ID, byte_index * 8U);
 		/* If Data block does not exist, need to exit */
@@ -272,6 +492,13 @@ unsigned long dp_get_header_bytes(unsigned long byte_index, unsigned char bytes_
 	unsigned char i;
 	unsigned char j = 0u;
 
+	if ((bytes_requested != 0U) && (dp_image_resident() == TRUE) && (byte_index < image_size) &&
+	    ((unsigned long)bytes_requested <= image_size - byte_index)) {
+		page_buffer_ptr = &image_buffer[byte_index];
+		return_bytes = (unsigned long)bytes_requested;
+		return dp_load_le(page_buffer_ptr, bytes_requested);
+	}
+
 	while (bytes_requested) {
 		page_buffer_ptr = dp_get_header_data(byte_index * 8U);
 		/* If Data block does not exist, need to exit */
@@ -15,6 +15,8 @@
 #ifndef INC_DPCOM_H
 #define INC_DPCOM_H
 
+#include "dpuser.h"
+
 extern unsigned long return_bytes;
 extern unsigned long image_size;
 extern unsigned long requested_bytes;
@@ -38,12 +40,46 @@ extern unsigned char
 #define IMAGE_SIZE_OFFSET      25u
 #define MIN_IMAGE_SIZE	       56u
 
+/* Block IDs are one byte wide */
+#define DP_BLOCK_DIRECTORY_SIZE 256u
+
+struct dp_block {
+	unsigned long address;
+	unsigned long length; /* 0 when the image has no such block */
+};
+
+#ifdef USE_PAGING
+/* The image is read from image_fd on demand into a small LRU set of pages.  More than
+ * one page is needed since the frame loop alternates between the datastream and the
+ * block count table. */
+#define PAGE_CACHE_ENTRIES   4u
+#define PAGE_CACHE_PAGE_SIZE 4096u
+
+struct dp_page {
+	unsigned long start_address;
+	unsigned long length; /* 0 when the entry is empty */
+	unsigned long last_used;
+	unsigned char data[PAGE_CACHE_PAGE_SIZE];
+};
+
+extern int image_fd;
+extern unsigned long page_cache_hits;
+extern unsigned long page_cache_misses;
+extern unsigned long page_cache_read_ahead;
+#endif
+
 void dp_init_com_vars(void);
 unsigned char *dp_get_data(unsigned char var_ID, unsigned long bit_index);
 unsigned char *dp_get_header_data(unsigned long bit_index);
-void dp_get_page_data(unsigned long image_requested_address);
+#ifdef USE_PAGING
+struct dp_page *dp_get_page_data(unsigned long image_requested_address);
+void dp_display_page_cache_stats(void);
+#endif
+void dp_parse_block_directory(void);
 void dp_get_data_block_address(unsigned char requested_var_ID);
+unsigned long dp_get_block_length(unsigned char var_ID);
 unsigned char *dp_get_data_block_element_address(unsigned long bit_index);
+unsigned char *dp_get_block_span(unsigned char var_ID, unsigned long byte_index, unsigned long *span_bytes);
 unsigned long dp_get_bytes(unsigned char var_ID, unsigned long byte_index, unsigned char bytes_requested);
 unsigned long dp_get_header_bytes(unsigned long byte_index, unsigned char bytes_requested);
 #endif /* INC_DPCOM_H */
@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpdaemon.c                                              */
+/*                                                                          */
+/*  Description:    Daemon mode.  The GPIO lines are claimed once and the   */
+/*  DAT images stay resident and validated between action requests that     */
+/*  arrive over a local Unix socket.                                        */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dpdaemon.h"
+
+#ifdef ENABLE_DAEMON_SUPPORT
+#include "dpSPIalg.h"
+#include "dpalg.h"
+#include "dpcom.h"
+#include "dpimage.h"
+#include "dptimer.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * Module: dp_run_daemon
+ * 		purpose: Serves action requests until a shutdown request is received.
+ *		The display output of every request is redirected to the requesting client
+ *		so that progress is streamed back while the action is running.
+ * Return value:
+ * 		0 on shutdown, -1 if the socket could not be set up.
+ *
+ */
+int dp_run_daemon(struct gpio_handle *jtag_gpio, signed char *socket_path)
+{
+	struct sockaddr_un address;
+	signed char request[DP_DAEMON_REQUEST_SIZE];
+	unsigned char shutdown_requested = FALSE;
+	unsigned char bound;
+	int server_fd;
+	int client_fd;
+	int stdout_fd;
+	mode_t old_umask;
+
+	/* A client that goes away must not terminate an action in progress */
+	signal(SIGPIPE, SIG_IGN);
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, (char *)socket_path, sizeof(address.sun_path) - 1u);
+
+	server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(address.sun_path);
+	/* Only the owner may connect: a request can erase or zeroize the device */
+	old_umask = umask(0077);
+	bound = ((server_fd >= 0) &&
+		 (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) == 0)) ? TRUE : FALSE;
+	umask(old_umask);
+	if ((bound == FALSE) || (listen(server_fd, DP_DAEMON_BACKLOG) != 0)) {
+		printf("Error: Failed to listen on %s\n", address.sun_path);
+		if (server_fd >= 0)
+			close(server_fd);
+		return -1;
+	}
+	printf("Listening on %s\n", address.sun_path);
+	fflush(stdout);
+	stdout_fd = dup(STDOUT_FILENO);
+
+	while (shutdown_requested == FALSE) {
+		client_fd = accept(server_fd, (struct sockaddr *)DPNULL, (socklen_t *)DPNULL);
+		if (client_fd < 0)
+			continue;
+
+		if (dp_daemon_read_request(client_fd, request) == TRUE) {
+			if (strcmp((char *)request, DP_DAEMON_SHUTDOWN) == 0) {
+				shutdown_requested = TRUE;
+			} else {
+				fflush(stdout);
+				dup2(client_fd, STDOUT_FILENO);
+				dp_daemon_run_job(jtag_gpio, request);
+				fflush(stdout);
+				dup2(stdout_fd, STDOUT_FILENO);
+			}
+		}
+		close(client_fd);
+	}
+
+	close(stdout_fd);
+	close(server_fd);
+	unlink(address.sun_path);
+	dp_release_resident_images();
+	return 0;
+}
+
+/*
+ * Module: dp_daemon_read_request
+ * 		purpose: Reads one newline terminated request line from the client.
+ * Return value:
+ * 		TRUE if a complete request was received.
+ *
+ */
+unsigned char dp_daemon_read_request(int client_fd, signed char *request)
+{
+	unsigned int length = 0u;
+	ssize_t received;
+
+	while (length < DP_DAEMON_REQUEST_SIZE - 1u) {
+		received = read(client_fd, &request[length], 1u);
+		if (received <= 0)
+			break;
+		if ((request[length] == '\n') || (request[length] == '\r')) {
+			request[length] = 0;
+			return TRUE;
+		}
+		length++;
+	}
+	request[length] = 0;
+	return (length > 0u) ? TRUE : FALSE;
+}
+
+/*
+ * Module: dp_daemon_run_job
+ * 		purpose: Executes a single "<action> <dat file> [<spi target address>]" request
+ *		with the resident copy of the image and reports the result line.  The DAT file
+ *		can be left out for the actions that don't need one, see dp_image_required.
+ * Return value:
+ * 		The error code of the action or the image load exit status.
+ *
+ */
+unsigned char dp_daemon_run_job(struct gpio_handle *jtag_gpio, signed char *request)
+{
+	signed char *pAction;
+	signed char *pFileName;
+#ifdef ENABLE_SPI_FLASH_SUPPORT
+	signed char *pAddress;
+#endif
+	struct dp_image *image = (struct dp_image *)DPNULL;
+	unsigned char iExecResult = DPE_SUCCESS;
+	unsigned long start_time;
+
+	start_time = dp_timer_ms();
+	pAction = (signed char *)strtok((char *)request, " \t");
+	pFileName = (signed char *)strtok((char *)DPNULL, " \t");
+#ifdef ENABLE_SPI_FLASH_SUPPORT
+	pAddress = (signed char *)strtok((char *)DPNULL, " \t");
+#endif
+
+	Action_code = DP_NO_ACTION_FOUND;
+	if (pAction != (signed char *)DPNULL)
+		Action_code = dp_get_Action_code(pAction);
+
+	if (Action_code == DP_NO_ACTION_FOUND) {
+		printf("\r\nError: Invalid action.");
+		iExecResult = DPE_ACTION_NOT_FOUND;
+	} else if (pFileName == (signed char *)DPNULL) {
+		if (dp_image_required(Action_code) == TRUE) {
+			printf("\r\nError: Dat file is required...\n");
+			iExecResult = DP_IMAGE_REQUIRED_ERROR;
+		} else {
+#ifdef ENABLE_SPI_FLASH_SUPPORT
+			spi_target_address = 0u;
+#endif
+			dp_deselect_image();
+			iExecResult = dp_top(jtag_gpio);
+		}
+	} else {
+		image = dp_get_resident_image(pFileName, &iExecResult);
+	}
+
+	if (image != (struct dp_image *)DPNULL) {
+#ifdef ENABLE_SPI_FLASH_SUPPORT
+		spi_target_address = 0u;
+		if (pAddress != (signed char *)DPNULL)
+			spi_target_address = strtoul((char *)pAddress, (char **)DPNULL, 0);
+#endif
+		dp_select_image(image);
+		iExecResult = dp_top(jtag_gpio);
+	}
+
+	printf("\r\nRESULT %u %lu\n", iExecResult, dp_timer_ms() - start_time);
+
+	return iExecResult;
+}
+#endif /* ENABLE_DAEMON_SUPPORT */
+
+/*   *************** End of File *************** */
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpdaemon.h                                              */
+/*                                                                          */
+/*  Description:    Contains function prototypes of the daemon mode which  */
+/*  accepts action requests over a local Unix socket                        */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPDAEMON_H
+#define INC_DPDAEMON_H
+
+#include "dpuser.h"
+
+#ifdef ENABLE_DAEMON_SUPPORT
+/*
+ * Request format, one request per connection:
+ *	<action> <dat file> [<spi target address>]\n
+ * The display output of the action is streamed back on the same connection and
+ * terminated with:
+ *	RESULT <error code> <elapsed milliseconds>\n
+ * The request "shutdown\n" stops the daemon.
+ */
+#define DP_DAEMON_REQUEST_SIZE 512u
+#define DP_DAEMON_BACKLOG      4
+#define DP_DAEMON_SHUTDOWN     "shutdown"
+
+int dp_run_daemon(struct gpio_handle *jtag_gpio, signed char *socket_path);
+unsigned char dp_daemon_read_request(int client_fd, signed char *request);
+unsigned char dp_daemon_run_job(struct gpio_handle *jtag_gpio, signed char *request);
+#endif
+
+#endif /* INC_DPDAEMON_H */
+
+/*   *************** End of File *************** */
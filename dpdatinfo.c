@@ -0,0 +1,519 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpdatinfo.c                                             */
+/*                                                                          */
+/*  Description:    dat_info action.  Decodes the header, the block         */
+/*  directory and the component table of the selected DAT file, checks     */
+/*  that they agree with each other and with the CRC, and estimates the     */
+/*  frames and TCK cycles of the actions that shift the datastreams.  No    */
+/*  JTAG access is made.                                                    */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dpdatinfo.h"
+#include "dpuser.h"
+#include "dpalg.h"
+#include "dpcom.h"
+#include "dputil.h"
+#include "dpG5alg.h"
+
+#include <stdio.h>
+
+unsigned int dat_info_problems;
+unsigned int dat_info_program_components;
+unsigned int dat_info_erase_components;
+unsigned long dat_info_program_frames;
+unsigned long dat_info_erase_frames;
+
+/* The report is the result of the action, so it is printed even without ENABLE_DISPLAY */
+static void dp_dat_info_text(signed char *text)
+{
+#ifdef ENABLE_DISPLAY
+	dp_display_text(text);
+#else
+	printf("%s", (char *)text);
+#endif
+	return;
+}
+
+static void dp_dat_info_problem(signed char *text)
+{
+	dat_info_problems++;
+	dp_dat_info_text("\r\n  Problem: ");
+	dp_dat_info_text(text);
+	return;
+}
+
+static void dp_dat_info_field(signed char *name, unsigned long value, unsigned int descriptive)
+{
+	signed char text[64];
+
+	snprintf((char *)text, sizeof(text), (descriptive == HEX) ? "\r\n  %-21s0x%lX" : "\r\n  %-21s%lu",
+		 (char *)name, value);
+	dp_dat_info_text(text);
+	return;
+}
+
+static signed char *dp_dat_info_block_name(unsigned char var_ID)
+{
+	switch (var_ID) {
+	case G5M_Header_ID:
+		return "header";
+	case G5M_USER_INFO_ID:
+		return "user info";
+	case G5M_ACT_UROW_DESIGN_NAME_ID:
+		return "design name";
+	case G5M_BsrPattern_ID:
+		return "BSR pattern";
+	case G5M_BsrPatternMask_ID:
+		return "BSR pattern mask";
+	case G5M_NUMBER_OF_BLOCKS_ID:
+		return "number of blocks";
+	case G5M_UPK1_ID:
+		return "UPK1";
+	case G5M_UPK2_ID:
+		return "UPK2";
+	case G5M_datastream_ID:
+		return "datastream";
+	case G5M_erasedatastream_ID:
+		return "erase datastream";
+	case G5M_DPK_ID:
+		return "DPK";
+	default:
+		return "unknown";
+	}
+}
+
+static signed char *dp_dat_info_component_name(unsigned char component_type)
+{
+	switch (component_type) {
+	case G5M_COMP_BITS:
+		return "BITS";
+	case G5M_COMP_FPGA:
+		return "FPGA";
+	case G5M_COMP_KEYS:
+		return "KEYS";
+	case G5M_COMP_SNVM:
+		return "sNVM";
+	case G5M_COMP_ENVM:
+		return "eNVM";
+	case G5M_COMP_OWP:
+		return "OWP";
+	case G5M_COMP_EOB:
+		return "EOB";
+	default:
+		return (signed char *)DPNULL;
+	}
+}
+
+/*
+ * Module: dp_dat_info_header
+ * 		purpose: Displays the header fields and checks the signature, the sizes and the
+ *		family.  loaded_size is the number of bytes of the image that was loaded.
+ * Return value:
+ * 		TRUE if the lookup table and the blocks can be decoded.
+ *
+ */
+static unsigned char dp_dat_info_header(unsigned long loaded_size)
+{
+	unsigned long signature;
+	unsigned long header_size;
+	unsigned long header_image_size;
+	signed char text[40];
+
+	signature = dp_get_bytes(Header_ID, 0u, 4u);
+	header_size = dp_get_bytes(Header_ID, HEADER_SIZE_OFFSET, 1u);
+	header_image_size = dp_get_bytes(Header_ID, IMAGE_SIZE_OFFSET, 4u);
+
+	snprintf((char *)text, sizeof(text), "\r\n  %-21s%c%c%c%c", "Signature:",
+		 (int)(signature & 0xFFu), (int)((signature >> 8) & 0xFFu),
+		 (int)((signature >> 16) & 0xFFu), (int)((signature >> 24) & 0xFFu));
+	dp_dat_info_text(text);
+	dp_dat_info_field("Header size:", header_size, DEC);
+	dp_dat_info_field("Image size:", header_image_size, DEC);
+	dp_dat_info_field("Loaded size:", loaded_size, DEC);
+	dp_dat_info_field("Family:",
+			  dp_get_bytes(Header_ID, G5M_DEVICE_FAMILY_OFFSET,
+				       G5M_DEVICE_FAMILY_BYTE_LENGTH),
+			  HEX);
+	dp_dat_info_field("ID:",
+			  dp_get_bytes(Header_ID, G5M_ID_OFFSET, G5M_ID_BYTE_LENGTH), HEX);
+	dp_dat_info_field("ID mask:",
+			  dp_get_bytes(Header_ID, G5M_ID_MASK_OFFSET, G5M_ID_MASK_BYTE_LENGTH), HEX);
+	dp_dat_info_field("Silicon signature:",
+			  dp_get_bytes(Header_ID, G5M_SILSIG_OFFSET, G5M_SILSIG_BYTE_LENGTH), HEX);
+	dp_dat_info_field("Checksum:",
+			  dp_get_bytes(Header_ID, G5M_CHECKSUM_OFFSET, G5M_CHECKSUM_BYTE_LENGTH), HEX);
+	dp_dat_info_field("BSR bits:",
+			  dp_get_bytes(Header_ID, G5M_NUMOFBSRBITS_OFFSET,
+				       G5M_NUMOFBSRBITS_BYTE_LENGTH),
+			  DEC);
+	dp_dat_info_field("Components:",
+			  dp_get_bytes(Header_ID, G5M_NUMOFCOMPONENT_OFFSET,
+				       G5M_NUMOFCOMPONENT_BYTE_LENGTH),
+			  DEC);
+	dp_dat_info_field("Data size:",
+			  dp_get_bytes(Header_ID, G5M_DATASIZE_OFFSET, G5M_DATASIZE_BYTE_LENGTH),
+			  DEC);
+	dp_dat_info_field("Erase data size:",
+			  dp_get_bytes(Header_ID, G5M_ERASEDATASIZE_OFFSET,
+				       G5M_ERASEDATASIZE_BYTE_LENGTH),
+			  DEC);
+	dp_dat_info_field("Verify data size:",
+			  dp_get_bytes(Header_ID, G5M_VERIFYDATASIZE_OFFSET,
+				       G5M_VERIFYDATASIZE_BYTE_LENGTH),
+			  DEC);
+	dp_dat_info_field("eNVM data size:",
+			  dp_get_bytes(Header_ID, G5M_ENVMDATASIZE_OFFSET,
+				       G5M_ENVMDATASIZE_BYTE_LENGTH),
+			  DEC);
+	dp_dat_info_field("eNVM verify size:",
+			  dp_get_bytes(Header_ID, G5M_ENVMVERIFYDATASIZE_OFFSET,
+				       G5M_ENVMVERIFYDATASIZE_BYTE_LENGTH),
+			  DEC);
+	dp_dat_info_field("UEK1 exists:",
+			  dp_get_bytes(Header_ID, G5M_UEK1_EXISTS_OFFSET, G5M_UEK1_EXISTS_BYTE_LENGTH),
+			  DEC);
+	dp_dat_info_field("UEK2 exists:",
+			  dp_get_bytes(Header_ID, G5M_UEK2_EXISTS_OFFSET, G5M_UEK2_EXISTS_BYTE_LENGTH),
+			  DEC);
+	dp_dat_info_field("DPK exists:",
+			  dp_get_bytes(Header_ID, G5M_DPK_EXISTS_OFFSET, G5M_DPK_EXISTS_BYTE_LENGTH),
+			  DEC);
+	dp_dat_info_field("UEK3 exists:",
+			  dp_get_bytes(Header_ID, G5M_UEK3_EXISTS_OFFSET, G5M_UEK3_EXISTS_BYTE_LENGTH),
+			  DEC);
+	dp_dat_info_field("Device exception:",
+			  dp_get_bytes(Header_ID, G5M_DEVICE_EXCEPTION_OFFSET,
+				       G5M_DEVICE_EXCEPTION_BYTE_LENGTH),
+			  DEC);
+
+	if ((signature != 0x69736544u) && (signature != 0x65746341u) &&
+	    (signature != 0x2D4D3447u) && (signature != 0x34475452u) &&
+	    (signature != 0x2D4D3547u)) {
+		dp_dat_info_problem("the file does not start with a DAT file signature");
+		return FALSE;
+	}
+	if (header_image_size > loaded_size) {
+		dp_dat_info_problem("the file is shorter than the image size in the header");
+		return FALSE;
+	}
+	if (header_image_size < loaded_size) {
+		dp_dat_info_problem("the file has data past the image size in the header");
+	}
+	if ((header_size <= G5M_DEVICE_EXCEPTION_OFFSET + 1u) ||
+	    (header_size + 2u > header_image_size)) {
+		dp_dat_info_problem("the header size is out of range");
+		return FALSE;
+	}
+	if (dp_get_bytes(Header_ID, G5M_DEVICE_FAMILY_OFFSET, G5M_DEVICE_FAMILY_BYTE_LENGTH) !=
+	    G5M_FAMILY_ID_IN_DAT) {
+		dp_dat_info_problem("the family is not PolarFire");
+	}
+	return TRUE;
+}
+
+/*
+ * Module: dp_dat_info_directory
+ * 		purpose: Displays the records of the lookup table and checks that every block lies
+ *		between the end of the table and the CRC, and that no block ID is listed twice.
+ *
+ */
+static void dp_dat_info_directory(void)
+{
+	unsigned char listed[DP_BLOCK_DIRECTORY_SIZE];
+	unsigned long table_address;
+	unsigned long table_end;
+	unsigned long record;
+	unsigned long block_address;
+	unsigned long block_length;
+	unsigned int num_vars;
+	unsigned int var_idx;
+	unsigned char variable_ID;
+	signed char text[64];
+
+	for (var_idx = 0u; var_idx < DP_BLOCK_DIRECTORY_SIZE; var_idx++) {
+		listed[var_idx] = FALSE;
+	}
+	table_address = dp_get_bytes(Header_ID, HEADER_SIZE_OFFSET, 1u);
+	num_vars = (unsigned int)dp_get_bytes(Header_ID, table_address - 1u, 1u);
+	table_end = table_address + BTYES_PER_TABLE_RECORD * num_vars;
+
+	dp_dat_info_text("\r\nBlock directory:");
+	dp_dat_info_text("\r\n   ID      Offset      Length  Name");
+	if (table_end + 2u > image_size) {
+		dp_dat_info_problem("the lookup table runs past the end of the image");
+		return;
+	}
+	for (var_idx = 0u; var_idx < num_vars; var_idx++) {
+		record = table_address + BTYES_PER_TABLE_RECORD * var_idx;
+		variable_ID = (unsigned char)dp_get_bytes(Header_ID, record, 1u);
+		block_address = dp_get_bytes(Header_ID, record + 1u, 4u);
+		block_length = dp_get_bytes(Header_ID, record + 5u, 4u);
+		snprintf((char *)text, sizeof(text), "\r\n  %3u  %10lu  %10lu  %s", variable_ID,
+			 block_address, block_length, (char *)dp_dat_info_block_name(variable_ID));
+		dp_dat_info_text(text);
+		if (variable_ID == Header_ID) {
+			dp_dat_info_problem("the lookup table lists the header as a block");
+		} else if (listed[variable_ID] == TRUE) {
+			dp_dat_info_problem("the block is listed more than once");
+		}
+		listed[variable_ID] = TRUE;
+		if ((block_address < table_end) || (block_address > image_size - 2u) ||
+		    (block_length > image_size - 2u - block_address)) {
+			dp_dat_info_problem("the block lies outside of the image data");
+		}
+	}
+	return;
+}
+
+static unsigned long dp_dat_info_component_blocks(unsigned int component)
+{
+	unsigned long blocks;
+
+	blocks = dp_get_bytes(G5M_NUMBER_OF_BLOCKS_ID, (unsigned long)(((component - 1u) * 22u) / 8u),
+			      4u);
+	blocks >>= ((component - 1u) * 22u) % 8u;
+	return blocks & 0x3FFFFFu;
+}
+
+/*
+ * Module: dp_dat_info_components
+ * 		purpose: Displays the block count and the type of every component and checks that
+ *		the block counts add up to the length of the datastream and erase datastream
+ *		blocks.  Components 1 to the data size are shifted from the datastream by program,
+ *		verify and enc_data_authentication, the last erase data size components from the
+ *		erase datastream by erase.
+ *
+ */
+static void dp_dat_info_components(void)
+{
+	unsigned int num_components;
+	unsigned int data_components;
+	unsigned int erase_components;
+	unsigned int component;
+	unsigned long blocks;
+	unsigned long datastream_length;
+	unsigned long erasedatastream_length;
+	unsigned long datastream_offset = 0u;
+	unsigned long erasedatastream_offset = 0u;
+	unsigned char component_type;
+	signed char *component_name;
+	signed char text[64];
+
+	num_components = (unsigned int)dp_get_bytes(Header_ID, G5M_NUMOFCOMPONENT_OFFSET,
+						   G5M_NUMOFCOMPONENT_BYTE_LENGTH);
+	data_components =
+	    (unsigned int)dp_get_bytes(Header_ID, G5M_DATASIZE_OFFSET, G5M_DATASIZE_BYTE_LENGTH);
+	erase_components = (unsigned int)dp_get_bytes(Header_ID, G5M_ERASEDATASIZE_OFFSET,
+						    G5M_ERASEDATASIZE_BYTE_LENGTH);
+	datastream_length = dp_get_block_length(G5M_datastream_ID);
+	erasedatastream_length = dp_get_block_length(G5M_erasedatastream_ID);
+
+	dp_dat_info_text("\r\nComponents:");
+	dp_dat_info_text("\r\n   No      Blocks  Type");
+	if (num_components == 0u) {
+		dp_dat_info_problem("the image has no components");
+		return;
+	}
+	if (data_components > num_components) {
+		dp_dat_info_problem("the data size is larger than the number of components");
+		data_components = num_components;
+	}
+	if (erase_components > num_components) {
+		dp_dat_info_problem("the erase data size is larger than the number of components");
+		erase_components = num_components;
+	}
+	dat_info_program_components = data_components;
+	dat_info_erase_components = erase_components;
+	/* Each 22 bit count is read as 4 bytes */
+	if (dp_get_block_length(G5M_NUMBER_OF_BLOCKS_ID) <
+	    ((num_components - 1u) * 22u) / 8u + 4u) {
+		dp_dat_info_problem("the number of blocks table is shorter than the components");
+		return;
+	}
+	if ((data_components != 0u) && (datastream_length == 0u)) {
+		dp_dat_info_problem("the datastream block is missing");
+	}
+	if ((erase_components != 0u) && (erasedatastream_length == 0u)) {
+		dp_dat_info_problem("the erase datastream block is missing");
+	}
+
+	for (component = 1u; component <= num_components; component++) {
+		blocks = dp_dat_info_component_blocks(component);
+		/* The type is in the first frame of the component, "-" if the stream ends first */
+		component_name = "-";
+		if (component <= data_components) {
+			if (datastream_offset + G5M_COMPONENT_TYPE_IN_HEADER_BYTE < datastream_length) {
+				component_type = (unsigned char)dp_get_bytes(
+				    G5M_datastream_ID,
+				    datastream_offset + G5M_COMPONENT_TYPE_IN_HEADER_BYTE, 1u);
+				component_name = dp_dat_info_component_name(component_type);
+			}
+		} else if (component > num_components - erase_components) {
+			if (erasedatastream_offset + G5M_COMPONENT_TYPE_IN_HEADER_BYTE <
+			    erasedatastream_length) {
+				component_type = (unsigned char)dp_get_bytes(
+				    G5M_erasedatastream_ID,
+				    erasedatastream_offset + G5M_COMPONENT_TYPE_IN_HEADER_BYTE, 1u);
+				component_name = dp_dat_info_component_name(component_type);
+			}
+		} else {
+		}
+		snprintf((char *)text, sizeof(text), "\r\n  %3u  %10lu  %s", component, blocks,
+			 (component_name != (signed char *)DPNULL) ? (char *)component_name
+								    : "unknown");
+		dp_dat_info_text(text);
+		if (blocks == 0u) {
+			dp_dat_info_problem("the component has no blocks");
+		}
+		if (component_name == (signed char *)DPNULL) {
+			dp_dat_info_problem("the component type is not known");
+		}
+		if (component <= data_components) {
+			datastream_offset += blocks * G5M_FRAME_BYTE_LENGTH;
+			dat_info_program_frames += blocks;
+		}
+		if (component > num_components - erase_components) {
+			erasedatastream_offset += blocks * G5M_FRAME_BYTE_LENGTH;
+			dat_info_erase_frames += blocks;
+		}
+	}
+
+	if (datastream_offset != datastream_length) {
+		dp_dat_info_problem("the block counts do not add up to the datastream length");
+		dp_dat_info_field("Counted bytes:", datastream_offset, DEC);
+		dp_dat_info_field("Datastream bytes:", datastream_length, DEC);
+	}
+	if (erasedatastream_offset != erasedatastream_length) {
+		dp_dat_info_problem("the block counts do not add up to the erase datastream length");
+		dp_dat_info_field("Counted bytes:", erasedatastream_offset, DEC);
+		dp_dat_info_field("Erase stream bytes:", erasedatastream_length, DEC);
+	}
+	return;
+}
+
+/*
+ * Module: dp_dat_info_bsr
+ * 		purpose: Checks that the BSR pattern and its mask hold the number of BSR bits given in
+ *		the header.
+ *
+ */
+static void dp_dat_info_bsr(void)
+{
+	unsigned long bsr_bits;
+
+	bsr_bits = dp_get_bytes(Header_ID, G5M_NUMOFBSRBITS_OFFSET, G5M_NUMOFBSRBITS_BYTE_LENGTH);
+	if ((bsr_bits == 0u) || (bsr_bits > MAX_BSR_BIT_SIZE)) {
+		dp_dat_info_problem("the number of BSR bits is out of range");
+	} else if ((dp_get_block_length(G5M_BsrPattern_ID) < (bsr_bits + 7u) / 8u) ||
+		   (dp_get_block_length(G5M_BsrPatternMask_ID) < (bsr_bits + 7u) / 8u)) {
+		dp_dat_info_problem("the BSR pattern is shorter than the number of BSR bits");
+	}
+	return;
+}
+
+/*
+ * Module: dp_dat_info_crc
+ * 		purpose: Compares the CRC stored at the end of the image with the CRC of the rest of
+ *		the image.  The whole image is always read, a check recorded for the file is not
+ *		trusted since the media may have changed under the same size and time.  Nothing is
+ *		recorded either, dat_info leaves the files and the store as they were.
+ *
+ */
+static void dp_dat_info_crc(void)
+{
+	unsigned int expected_crc;
+	unsigned int actual_crc = 0u;
+	unsigned long crc_index = 0u;
+	unsigned long remaining;
+	unsigned char *data;
+
+	expected_crc = (unsigned int)dp_get_bytes(Header_ID, image_size - 2u, 2u);
+	dp_dat_info_field("Stored CRC:", expected_crc, HEX);
+
+	remaining = image_size - 2u;
+	while (remaining != 0u) {
+		data = dp_get_data(Header_ID, crc_index * 8u);
+		if (return_bytes == 0u)
+			break;
+		if (return_bytes > remaining)
+			return_bytes = remaining;
+		actual_crc = dp_crc16_update(actual_crc, data, return_bytes);
+		crc_index += return_bytes;
+		remaining -= return_bytes;
+	}
+	dp_dat_info_field("Actual CRC:", actual_crc, HEX);
+	if ((remaining != 0u) || (actual_crc != expected_crc))
+		dp_dat_info_problem("the CRC does not match");
+	return;
+}
+
+static void dp_dat_info_estimate(signed char *actions, unsigned int components,
+				 unsigned long frames)
+{
+	signed char text[128];
+
+	snprintf((char *)text, sizeof(text), "\r\n  %s: %lu frames, %lu TCK cycles", (char *)actions,
+		 frames, components * DP_DAT_INFO_COMPONENT_TCK + frames * DP_DAT_INFO_FRAME_TCK);
+	dp_dat_info_text(text);
+	return;
+}
+
+/*
+ * Module: dp_dat_info_action
+ * 		purpose: Decodes and checks the selected image.  image_size must still hold the
+ *		number of bytes loaded by dp_select_image.  The TCK estimate assumes that the
+ *		device is ready at the first poll of every frame.
+ * Return value:
+ * 		error_code is DPE_CRC_MISMATCH or DPE_DAT_ACCESS_FAILURE when a problem was found.
+ *
+ */
+void dp_dat_info_action(void)
+{
+	unsigned long loaded_size = image_size;
+	unsigned int crc_problems;
+	signed char text[40];
+
+	dat_info_problems = 0u;
+	dat_info_program_components = 0u;
+	dat_info_erase_components = 0u;
+	dat_info_program_frames = 0u;
+	dat_info_erase_frames = 0u;
+	dp_dat_info_text("\r\nDAT file information:");
+	if (dp_dat_info_header(loaded_size) == TRUE) {
+		/* Also sets image_size from the header */
+		dp_parse_block_directory();
+		dp_dat_info_directory();
+		dp_dat_info_components();
+		dp_dat_info_bsr();
+
+		crc_problems = dat_info_problems;
+		dp_dat_info_text("\r\nCRC:");
+		dp_dat_info_crc();
+		crc_problems = dat_info_problems - crc_problems;
+
+		dp_dat_info_text("\r\nEstimated JTAG traffic:");
+		dp_dat_info_estimate("program, verify, enc_data_authentication",
+				     dat_info_program_components, dat_info_program_frames);
+		dp_dat_info_estimate("erase", dat_info_erase_components, dat_info_erase_frames);
+	} else {
+		crc_problems = 0u;
+	}
+
+	snprintf((char *)text, sizeof(text), "\r\nProblems found: %u", dat_info_problems);
+	dp_dat_info_text(text);
+	if (dat_info_problems != crc_problems) {
+		error_code = DPE_DAT_ACCESS_FAILURE;
+	} else if (crc_problems != 0u) {
+		error_code = DPE_CRC_MISMATCH;
+	} else {
+	}
+	return;
+}
+
+/*   *************** End of File *************** */
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpdatinfo.h                                             */
+/*                                                                          */
+/*  Description:    Contains function prototypes of the dat_info action     */
+/*  that decodes and checks a DAT file without a device attached            */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPDATINFO_H
+#define INC_DPDATINFO_H
+
+/*
+ * TCK cycles of one frame of the G5 frame loop when the device is ready at the first poll:
+ * Run-Test/Idle with G5M_STANDARD_CYCLES (3 + 3), the FRAME_DATA IR scan (5 + 8 + 1) and the
+ * 128 bit DR scan that shifts the next frame while polling (5 + 128 + 1).
+ */
+#define DP_DAT_INFO_FRAME_TCK	  154u
+/* TCK cycles of the IR and DR scan that load the first frame of a component */
+#define DP_DAT_INFO_COMPONENT_TCK 149u
+
+void dp_dat_info_action(void);
+
+#endif /* INC_DPDATINFO_H */
+
+/*   *************** End of File *************** */
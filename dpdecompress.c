@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpdecompress.c                                          */
+/*                                                                          */
+/*  Description:    Loads gzip (ENABLE_GZIP_SUPPORT) and zstd               */
+/*  (ENABLE_ZSTD_SUPPORT) compressed DAT files.  The file is decompressed   */
+/*  in one streaming pass into a dp_image_sink, which places it straight    */
+/*  in the image buffer and computes the image CRC on the way.              */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dpdecompress.h"
+#include "dpuser.h"
+
+#include <string.h>
+#include <unistd.h>
+#ifdef ENABLE_GZIP_SUPPORT
+#include <zlib.h>
+#endif
+#ifdef ENABLE_ZSTD_SUPPORT
+#include <zstd.h>
+#endif
+
+#if defined(ENABLE_GZIP_SUPPORT) || defined(ENABLE_ZSTD_SUPPORT)
+/* Size of the compressed input read from the file at a time */
+#define DP_DECOMPRESS_INPUT_SIZE 65536u
+
+/*
+ * Module: dp_read_input
+ * 		purpose: Refills the compressed input, starting with the bytes that were read from
+ *		the file to recognize its format.
+ * Return value:
+ * 		The number of bytes in input, 0 at end of file or -1 on a read error.
+ *
+ */
+static long dp_read_input(int fd, unsigned char **prefix, unsigned long *prefix_length,
+			  unsigned char *input)
+{
+	long received;
+
+	if (*prefix_length != 0u) {
+		memcpy(input, *prefix, *prefix_length);
+		received = (long)*prefix_length;
+		*prefix_length = 0u;
+		return received;
+	}
+	return (long)read(fd, input, DP_DECOMPRESS_INPUT_SIZE);
+}
+#endif
+
+#ifdef ENABLE_GZIP_SUPPORT
+static unsigned char dp_inflate_image(int fd, unsigned char *prefix, unsigned long prefix_length,
+				      struct dp_image_sink *sink, unsigned char *input)
+{
+	z_stream stream;
+	unsigned char *output;
+	unsigned long space;
+	long received;
+	unsigned char status = DP_IMAGE_LOADED;
+	int result = Z_OK;
+
+	memset(&stream, 0, sizeof(stream));
+	/* 32 lets zlib detect the gzip header */
+	if (inflateInit2(&stream, 15 + 32) != Z_OK)
+		return DP_IMAGE_MEMORY_ERROR;
+
+	for (;;) {
+		if (stream.avail_in == 0u) {
+			received = dp_read_input(fd, &prefix, &prefix_length, input);
+			if (received < 0) {
+				status = DP_IMAGE_READ_ERROR;
+				break;
+			}
+			if (received == 0) {
+				/* The input must end with a complete gzip member */
+				if (result != Z_STREAM_END)
+					status = DP_IMAGE_READ_ERROR;
+				break;
+			}
+			stream.next_in = input;
+			stream.avail_in = (uInt)received;
+		}
+		if (result == Z_STREAM_END) {
+			/* Concatenated gzip members */
+			inflateReset(&stream);
+		}
+		output = dp_image_sink_space(sink, &space);
+		if (output == (unsigned char *)DPNULL) {
+			status = DP_IMAGE_MEMORY_ERROR;
+			break;
+		}
+		stream.next_out = output;
+		stream.avail_out = (uInt)space;
+		result = inflate(&stream, Z_NO_FLUSH);
+		if ((result != Z_OK) && (result != Z_STREAM_END) && (result != Z_BUF_ERROR)) {
+			status = DP_IMAGE_READ_ERROR;
+			break;
+		}
+		dp_image_sink_written(sink, output, space - stream.avail_out);
+	}
+	inflateEnd(&stream);
+	return status;
+}
+#endif
+
+#ifdef ENABLE_ZSTD_SUPPORT
+static unsigned char dp_zstd_image(int fd, unsigned char *prefix, unsigned long prefix_length,
+				   struct dp_image_sink *sink, unsigned char *input)
+{
+	ZSTD_DStream *stream;
+	ZSTD_inBuffer in;
+	ZSTD_outBuffer out;
+	unsigned long space;
+	long received;
+	unsigned char status = DP_IMAGE_LOADED;
+	size_t result = 0u;
+
+	stream = ZSTD_createDStream();
+	if (stream == (ZSTD_DStream *)DPNULL)
+		return DP_IMAGE_MEMORY_ERROR;
+	ZSTD_initDStream(stream);
+
+	in.src = input;
+	in.size = 0u;
+	in.pos = 0u;
+	for (;;) {
+		if (in.pos == in.size) {
+			received = dp_read_input(fd, &prefix, &prefix_length, input);
+			if (received < 0) {
+				status = DP_IMAGE_READ_ERROR;
+				break;
+			}
+			if (received == 0) {
+				/* 0 means the last frame was complete */
+				if (result != 0u)
+					status = DP_IMAGE_READ_ERROR;
+				break;
+			}
+			in.size = (size_t)received;
+			in.pos = 0u;
+		}
+		out.dst = dp_image_sink_space(sink, &space);
+		if (out.dst == DPNULL) {
+			status = DP_IMAGE_MEMORY_ERROR;
+			break;
+		}
+		out.size = (size_t)space;
+		out.pos = 0u;
+		result = ZSTD_decompressStream(stream, &out, &in);
+		if (ZSTD_isError(result)) {
+			status = DP_IMAGE_READ_ERROR;
+			break;
+		}
+		dp_image_sink_written(sink, (unsigned char *)out.dst, (unsigned long)out.pos);
+	}
+	ZSTD_freeDStream(stream);
+	return status;
+}
+#endif
+
+/*
+ * Module: dp_compression_format
+ * 		purpose: Recognizes a compressed file from its first bytes.  Formats whose support
+ *		is not compiled in are reported as DP_COMPRESSION_NONE.
+ * Return value:
+ * 		DP_COMPRESSION_NONE, DP_COMPRESSION_GZIP or DP_COMPRESSION_ZSTD.
+ *
+ */
+unsigned char dp_compression_format(unsigned char *magic, unsigned long length)
+{
+	unsigned char format = DP_COMPRESSION_NONE;
+
+#ifdef ENABLE_GZIP_SUPPORT
+	if ((length >= 2u) && (magic[0] == 0x1Fu) && (magic[1] == 0x8Bu))
+		format = DP_COMPRESSION_GZIP;
+#endif
+#ifdef ENABLE_ZSTD_SUPPORT
+	if ((length >= 4u) && (magic[0] == 0x28u) && (magic[1] == 0xB5u) && (magic[2] == 0x2Fu) &&
+	    (magic[3] == 0xFDu))
+		format = DP_COMPRESSION_ZSTD;
+#endif
+	return format;
+}
+
+/*
+ * Module: dp_decompress_image
+ * 		purpose: Decompresses the rest of fd into image->buffer.  prefix holds the bytes
+ *		already read from fd by dp_compression_format.  The decompressed image is kept
+ *		in memory in USE_PAGING builds as well since a compressed file cannot be read
+ *		at random offsets.
+ * Return value:
+ * 		DP_IMAGE_LOADED or the exit status describing why the file could not be loaded.
+ *
+ */
+unsigned char dp_decompress_image(int fd, unsigned char format, unsigned char *prefix,
+				  unsigned long prefix_length, struct dp_image *image)
+{
+	unsigned char status = DP_IMAGE_READ_ERROR;
+#if defined(ENABLE_GZIP_SUPPORT) || defined(ENABLE_ZSTD_SUPPORT)
+	struct dp_image_sink sink;
+	unsigned char *input;
+
+	dp_image_sink_init(&sink, image);
+	input = (unsigned char *)dp_malloc(DP_DECOMPRESS_INPUT_SIZE);
+	if (input == (unsigned char *)DPNULL)
+		return DP_IMAGE_MEMORY_ERROR;
+
+#ifdef ENABLE_GZIP_SUPPORT
+	if (format == DP_COMPRESSION_GZIP)
+		status = dp_inflate_image(fd, prefix, prefix_length, &sink, input);
+#endif
+#ifdef ENABLE_ZSTD_SUPPORT
+	if (format == DP_COMPRESSION_ZSTD)
+		status = dp_zstd_image(fd, prefix, prefix_length, &sink, input);
+#endif
+	dp_free(input);
+	if (status == DP_IMAGE_LOADED)
+		status = dp_image_sink_finish(&sink);
+	if (status != DP_IMAGE_LOADED) {
+#ifdef ENABLE_DISPLAY
+		if (status == DP_IMAGE_MEMORY_ERROR)
+			dp_display_text("\r\nError: can't allocate memory for the decompressed image\n");
+		else
+			dp_display_text("\r\nError decompressing file \n");
+		dp_display_text(image->path);
+#endif
+		if (image->buffer != (unsigned char *)DPNULL)
+			dp_free(image->buffer);
+		image->buffer = (unsigned char *)DPNULL;
+		image->size = 0u;
+		image->crc_checked = FALSE;
+	}
+#endif
+	return status;
+}
+
+/*   *************** End of File *************** */
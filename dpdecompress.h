@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpdecompress.h                                          */
+/*                                                                          */
+/*  Description:    Contains function prototypes to load gzip and zstd      */
+/*  compressed DAT files                                                    */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPDECOMPRESS_H
+#define INC_DPDECOMPRESS_H
+
+#include "dpimage.h"
+
+/* Number of leading bytes needed to recognize a compressed file */
+#define DP_COMPRESSION_MAGIC_SIZE 4u
+
+#define DP_COMPRESSION_NONE 0u
+#define DP_COMPRESSION_GZIP 1u
+#define DP_COMPRESSION_ZSTD 2u
+
+unsigned char dp_compression_format(unsigned char *magic, unsigned long length);
+unsigned char dp_decompress_image(int fd, unsigned char format, unsigned char *prefix,
+				  unsigned long prefix_length, struct dp_image *image);
+
+#endif /* INC_DPDECOMPRESS_H */
+
+/*   *************** End of File *************** */
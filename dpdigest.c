@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpdigest.c                                              */
+/*                                                                          */
+/*  Description:    Store of the segment digests that a DAT file leaves in  */
+/*  the device once programmed, used by program_if_different.               */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dpdigest.h"
+#include "dpalg.h"
+#include "dpcom.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Module: dp_digest_key
+ * 		purpose: Fills in the key of the record: the size and the CRC of the loaded DAT
+ *		file and its bitstream digest.
+ *
+ */
+static void dp_digest_key(struct dp_digest_record *record, unsigned char *bitstream_digest)
+{
+	memset(record, 0, sizeof(*record));
+	record->magic = DP_DIGEST_MAGIC;
+	record->image_size = dp_get_bytes(Header_ID, IMAGE_SIZE_OFFSET, 4u);
+	record->image_crc = (unsigned int)dp_get_bytes(Header_ID, record->image_size - 2u, 2u);
+	memcpy(record->bitstream_digest, bitstream_digest, DP_DIGEST_SIZE);
+	return;
+}
+
+static unsigned char dp_digest_same_key(struct dp_digest_record *a, struct dp_digest_record *b)
+{
+	return ((a->magic == b->magic) && (a->image_size == b->image_size) &&
+		(a->image_crc == b->image_crc) &&
+		(memcmp(a->bitstream_digest, b->bitstream_digest, DP_DIGEST_SIZE) == 0))
+		   ? TRUE
+		   : FALSE;
+}
+
+/*
+ * Module: dp_digest_matches
+ * 		purpose: Looks for the record of the loaded DAT file and compares the segment
+ *		digests it holds with the ones read from the device.
+ * Return value:
+ * 		TRUE if the device holds the digests recorded after the file was last programmed.
+ *
+ */
+unsigned char dp_digest_matches(unsigned char *bitstream_digest, unsigned char *segment_digests)
+{
+	struct dp_digest_record key;
+	struct dp_digest_record record;
+	unsigned char matches = FALSE;
+	int fd;
+
+	dp_digest_key(&key, bitstream_digest);
+	fd = open(DP_DIGEST_STORE, O_RDONLY);
+	if (fd < 0)
+		return FALSE;
+	flock(fd, LOCK_SH);
+	while (read(fd, &record, sizeof(record)) == (ssize_t)sizeof(record)) {
+		if (dp_digest_same_key(&key, &record) == TRUE) {
+			matches = (memcmp(record.segment_digests, segment_digests,
+					  DP_DIGEST_SEGMENT_BYTES) == 0)
+				      ? TRUE
+				      : FALSE;
+			break;
+		}
+	}
+	close(fd);
+	return matches;
+}
+
+/*
+ * Module: dp_digest_record
+ * 		purpose: Records the segment digests read from the device after the loaded DAT file
+ *		was programmed, replacing the record of the same file, or else the least recently
+ *		written record once the store is full.  Concurrent runs are serialized with flock.
+ *		Failing to write the store only means that the next run programs the device.
+ *
+ */
+void dp_digest_record(unsigned char *bitstream_digest, unsigned char *segment_digests)
+{
+	struct dp_digest_record key;
+	struct dp_digest_record record;
+	char directory[sizeof(DP_DIGEST_STORE)];
+	unsigned long slot = 0u;
+	unsigned long oldest = 0u;
+	unsigned long index = 0u;
+	unsigned long sequence = 0u;
+	unsigned char same_file = FALSE;
+	int fd;
+
+	dp_digest_key(&key, bitstream_digest);
+	memcpy(key.segment_digests, segment_digests, DP_DIGEST_SEGMENT_BYTES);
+
+	strcpy(directory, DP_DIGEST_STORE);
+	*strrchr(directory, '/') = '\0';
+	mkdir(directory, 0755);
+	fd = open(DP_DIGEST_STORE, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+		return;
+	flock(fd, LOCK_EX);
+	while ((index < DP_DIGEST_STORE_ENTRIES) &&
+	       (read(fd, &record, sizeof(record)) == (ssize_t)sizeof(record))) {
+		if (record.sequence > sequence)
+			sequence = record.sequence;
+		if ((same_file == FALSE) && (dp_digest_same_key(&key, &record) == TRUE)) {
+			same_file = TRUE;
+			slot = index;
+		}
+		if ((same_file == FALSE) && ((index == 0u) || (record.sequence < oldest))) {
+			oldest = record.sequence;
+			slot = index;
+		}
+		index++;
+	}
+	/* A free entry is used before the least recently written one */
+	if ((same_file == FALSE) && (index < DP_DIGEST_STORE_ENTRIES))
+		slot = index;
+	key.sequence = sequence + 1u;
+	if (pwrite(fd, &key, sizeof(key), (off_t)(slot * sizeof(key))) != (ssize_t)sizeof(key))
+		ftruncate(fd, (off_t)(slot * sizeof(key)));
+	close(fd);
+	return;
+}
+
+/*   *************** End of File *************** */
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpdigest.h                                              */
+/*                                                                          */
+/*  Description:    Contains function prototypes of the store of segment    */
+/*  digests that program_if_different compares with the device              */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPDIGEST_H
+#define INC_DPDIGEST_H
+
+#include "dpuser.h"
+
+/*
+ * After program_if_different programs a DAT file, the segment digests read back from the device
+ * are recorded here, keyed by the file.  A later run with the same file skips programming when
+ * the device returns the same digests.  The store holds DP_DIGEST_STORE_ENTRIES records, the
+ * least recently written one is replaced once it is full.
+ */
+#define DP_DIGEST_STORE		"/var/cache/directc/digest.store"
+#define DP_DIGEST_STORE_ENTRIES 256u
+#define DP_DIGEST_MAGIC		0x44475044u /* "DPGD" */
+#define DP_DIGEST_SIZE		32u
+/*
+ * READ_DIGEST returns 13 digests.  The first 12 (fabric, UFS CC, sNVM, UFS UL, user keys 0 to 6
+ * and UFS UPERM) follow from the design and are compared.  The last one, the factory digest,
+ * differs from device to device.
+ */
+#define DP_DIGEST_SEGMENT_BYTES (12u * DP_DIGEST_SIZE)
+
+struct dp_digest_record {
+	unsigned long magic;
+	unsigned long sequence;	  /* Order of the writes to the store, see dp_digest_record */
+	unsigned long image_size; /* Key: size, CRC and bitstream digest of the DAT file */
+	unsigned int image_crc;
+	unsigned char bitstream_digest[DP_DIGEST_SIZE];
+	unsigned char segment_digests[DP_DIGEST_SEGMENT_BYTES];
+};
+
+unsigned char dp_digest_matches(unsigned char *bitstream_digest, unsigned char *segment_digests);
+void dp_digest_record(unsigned char *bitstream_digest, unsigned char *segment_digests);
+
+#endif /* INC_DPDIGEST_H */
+
+/*   *************** End of File *************** */
@@ -0,0 +1,314 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dphistory.c                                             */
+/*                                                                          */
+/*  Description:    Local programming history.  Every action run on a       */
+/*  PolarFire device is appended to an indexed file, so that the actions    */
+/*  of a device or of a design are found without scanning the history.     */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dphistory.h"
+#include "dpalg.h"
+#include "dpG5alg.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DP_HISTORY_DSN_TABLE	DP_HISTORY_HEADER_SIZE
+#define DP_HISTORY_DESIGN_TABLE (DP_HISTORY_DSN_TABLE + DP_HISTORY_BUCKETS * 4u)
+#define DP_HISTORY_RECORDS	(DP_HISTORY_DESIGN_TABLE + DP_HISTORY_BUCKETS * 4u)
+
+/* FNV-1a, 32 bit */
+static unsigned int dp_history_hash(unsigned char *key, unsigned int length)
+{
+	unsigned int hash = 2166136261u;
+
+	while (length--) {
+		hash ^= *key++;
+		hash *= 16777619u;
+	}
+	return hash % DP_HISTORY_BUCKETS;
+}
+
+static off_t dp_history_record_offset(unsigned int number)
+{
+	return (off_t)DP_HISTORY_RECORDS + (off_t)number * (off_t)sizeof(struct dp_history_record);
+}
+
+static unsigned int dp_history_bucket(int fd, unsigned long table, unsigned int bucket)
+{
+	unsigned int head = 0u;
+
+	if (pread(fd, &head, sizeof(head), (off_t)(table + bucket * 4u)) != (ssize_t)sizeof(head))
+		return 0u;
+	return head;
+}
+
+/*
+ * Module: dp_history_open
+ * 		purpose: Opens the history file and reads its header.  With create set, a missing
+ *		file is created.
+ * Return value:
+ * 		The file descriptor, or -1 if there is no usable history file.
+ *
+ */
+static int dp_history_open(unsigned char create, struct dp_history_file_header *header)
+{
+	char directory[sizeof(DP_HISTORY_STORE)];
+	int fd;
+
+	if (create == TRUE) {
+		strcpy(directory, DP_HISTORY_STORE);
+		*strrchr(directory, '/') = '\0';
+		mkdir(directory, 0755);
+		fd = open(DP_HISTORY_STORE, O_RDWR | O_CREAT, 0644);
+	} else {
+		fd = open(DP_HISTORY_STORE, O_RDONLY);
+	}
+	if (fd < 0)
+		return -1;
+	flock(fd, (create == TRUE) ? LOCK_EX : LOCK_SH);
+
+	if (pread(fd, header, sizeof(*header), 0) != (ssize_t)sizeof(*header)) {
+		/* A new file: the tables are left as a hole until buckets are used */
+		header->magic = DP_HISTORY_MAGIC;
+		header->record_size = sizeof(struct dp_history_record);
+		header->buckets = DP_HISTORY_BUCKETS;
+		header->records = 0u;
+		if ((create == FALSE) ||
+		    (pwrite(fd, header, sizeof(*header), 0) != (ssize_t)sizeof(*header)) ||
+		    (ftruncate(fd, (off_t)DP_HISTORY_RECORDS) != 0)) {
+			close(fd);
+			return -1;
+		}
+	}
+	if ((header->magic != DP_HISTORY_MAGIC) ||
+	    (header->record_size != sizeof(struct dp_history_record)) ||
+	    (header->buckets != DP_HISTORY_BUCKETS)) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/*
+ * Module: dp_history_append
+ * 		purpose: Appends a record to the history and links it into its DSN and design
+ *		buckets.  The record is written before the buckets point to it, so an interrupted
+ *		append leaves at most an unreachable record.  Concurrent runs are serialized with
+ *		flock.  Failing to write the history does not affect the action.
+ *
+ */
+void dp_history_append(struct dp_history_record *record)
+{
+	struct dp_history_file_header header;
+	unsigned int dsn_bucket;
+	unsigned int design_bucket;
+	unsigned int number;
+	int fd;
+
+	fd = dp_history_open(TRUE, &header);
+	if (fd < 0)
+		return;
+	number = header.records;
+	dsn_bucket = dp_history_hash(record->dsn, DP_HISTORY_DSN_SIZE);
+	design_bucket = dp_history_hash(record->design_name, DP_HISTORY_DESIGN_SIZE);
+	record->previous_dsn = dp_history_bucket(fd, DP_HISTORY_DSN_TABLE, dsn_bucket);
+	record->previous_design = dp_history_bucket(fd, DP_HISTORY_DESIGN_TABLE, design_bucket);
+
+	number++;
+	if ((pwrite(fd, record, sizeof(*record), dp_history_record_offset(header.records)) ==
+	     (ssize_t)sizeof(*record)) &&
+	    (pwrite(fd, &number, sizeof(number),
+		    (off_t)(DP_HISTORY_DSN_TABLE + dsn_bucket * 4u)) == (ssize_t)sizeof(number)) &&
+	    (pwrite(fd, &number, sizeof(number),
+		    (off_t)(DP_HISTORY_DESIGN_TABLE + design_bucket * 4u)) ==
+	     (ssize_t)sizeof(number))) {
+		header.records = number;
+		pwrite(fd, &header, sizeof(header), 0);
+	}
+	close(fd);
+	return;
+}
+
+/*
+ * Module: dp_history_find
+ * 		purpose: Reads the records of a device (DP_HISTORY_BY_DSN, key holds the
+ *		DP_HISTORY_DSN_SIZE bytes of the DSN) or of a design (DP_HISTORY_BY_DESIGN, key
+ *		holds the DP_HISTORY_DESIGN_SIZE bytes of the name padded with zeros), newest first.
+ * Return value:
+ * 		The number of records copied to records, at most max_records.
+ *
+ */
+unsigned long dp_history_find(unsigned char key_type, unsigned char *key,
+			      struct dp_history_record *records, unsigned long max_records)
+{
+	struct dp_history_file_header header;
+	struct dp_history_record *record;
+	unsigned int key_size;
+	unsigned int number;
+	unsigned long found = 0u;
+	int fd;
+
+	fd = dp_history_open(FALSE, &header);
+	if (fd < 0)
+		return 0u;
+	key_size = (key_type == DP_HISTORY_BY_DSN) ? DP_HISTORY_DSN_SIZE : DP_HISTORY_DESIGN_SIZE;
+	number = dp_history_bucket(fd,
+				   (key_type == DP_HISTORY_BY_DSN) ? DP_HISTORY_DSN_TABLE
+								   : DP_HISTORY_DESIGN_TABLE,
+				   dp_history_hash(key, key_size));
+	while ((number != 0u) && (number <= header.records) && (found < max_records)) {
+		record = &records[found];
+		if (pread(fd, record, sizeof(*record), dp_history_record_offset(number - 1u)) !=
+		    (ssize_t)sizeof(*record))
+			break;
+		if (memcmp((key_type == DP_HISTORY_BY_DSN) ? record->dsn : record->design_name, key,
+			   key_size) == 0)
+			found++;
+		/* Links only point to older records, which ends a damaged chain too */
+		if (((key_type == DP_HISTORY_BY_DSN) ? record->previous_dsn
+						      : record->previous_design) >= number)
+			break;
+		number = (key_type == DP_HISTORY_BY_DSN) ? record->previous_dsn
+							 : record->previous_design;
+	}
+	close(fd);
+	return found;
+}
+
+/*
+ * Module: dp_history_parse_dsn
+ * 		purpose: Reads a DSN given as 32 hex digits, most significant byte first as
+ *		device_info displays it.
+ * Return value:
+ * 		TRUE if text is a DSN.
+ *
+ */
+static unsigned char dp_history_parse_dsn(signed char *text, unsigned char *dsn)
+{
+	unsigned int index;
+	unsigned int digit;
+	char character;
+
+	if (strlen((char *)text) != 2u * DP_HISTORY_DSN_SIZE)
+		return FALSE;
+	memset(dsn, 0, DP_HISTORY_DSN_SIZE);
+	for (index = 0u; index < 2u * DP_HISTORY_DSN_SIZE; index++) {
+		character = (char)text[index];
+		if (!isxdigit((unsigned char)character))
+			return FALSE;
+		digit = isdigit((unsigned char)character)
+			    ? (unsigned int)(character - '0')
+			    : (unsigned int)(tolower((unsigned char)character) - 'a' + 10);
+		dsn[DP_HISTORY_DSN_SIZE - 1u - index / 2u] |=
+		    (unsigned char)(digit << ((index % 2u == 0u) ? 4u : 0u));
+	}
+	return TRUE;
+}
+
+/*
+ * Module: dp_history_show
+ * 		purpose: Displays the newest records of a device, given its DSN as 32 hex digits, or
+ *		of a design, given its name.  The device is not accessed.  A device whose last
+ *		recorded cycle count is within DP_HISTORY_CYCLE_MARGIN of
+ *		G5M_MAX_ALLOWED_PROGRAMMING_CYCLES is flagged.
+ * Return value:
+ * 		0 if records were found, 1 otherwise.
+ *
+ */
+int dp_history_show(signed char *key)
+{
+	struct dp_history_record records[DP_HISTORY_MAX_SHOWN];
+	unsigned char key_bytes[DP_HISTORY_DESIGN_SIZE];
+	unsigned char key_type = DP_HISTORY_BY_DESIGN;
+	unsigned long found;
+	unsigned long index;
+#ifdef ENABLE_DISPLAY
+	struct dp_history_record *record;
+	signed char text[160];
+	char when[24];
+	char name[DP_HISTORY_DESIGN_SIZE + 1u];
+	char dsn[2u * DP_HISTORY_DSN_SIZE + 1u];
+	time_t seconds;
+	unsigned int byte;
+#endif
+
+	memset(key_bytes, 0, sizeof(key_bytes));
+	if (dp_history_parse_dsn(key, key_bytes) == TRUE) {
+		key_type = DP_HISTORY_BY_DSN;
+	} else {
+		strncpy((char *)key_bytes, (char *)key, DP_HISTORY_DESIGN_SIZE);
+	}
+	found = dp_history_find(key_type, key_bytes, records, DP_HISTORY_MAX_SHOWN);
+
+#ifdef ENABLE_DISPLAY
+	if (found == 0u) {
+		dp_display_text("\r\nNo history for ");
+		dp_display_text(key);
+		dp_display_text("\r\n");
+		return 1;
+	}
+	dp_display_text("\r\nNewest first:");
+	dp_display_text("\r\nTime                 DSN                               Action                   Result  "
+			"    ms  Cycles  Design");
+	for (index = 0u; index < found; index++) {
+		record = &records[index];
+		seconds = (time_t)record->time;
+		strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&seconds));
+		for (byte = 0u; byte < DP_HISTORY_DSN_SIZE; byte++)
+			snprintf(&dsn[2u * byte], 3u, "%02X",
+				 record->dsn[DP_HISTORY_DSN_SIZE - 1u - byte]);
+		memcpy(name, record->design_name, DP_HISTORY_DESIGN_SIZE);
+		name[DP_HISTORY_DESIGN_SIZE] = '\0';
+		snprintf((char *)text, sizeof(text), "\r\n%s  %s  %-23s  %6u  %6u  ", when, dsn,
+			 (char *)dp_get_Action_name(record->action), record->result,
+			 record->duration_ms);
+		dp_display_text(text);
+		if (record->cycle_count == DP_HISTORY_NO_CYCLE_COUNT)
+			snprintf((char *)text, sizeof(text), "%6s  %s %02X%02X", "-", name,
+				 record->design_checksum[1], record->design_checksum[0]);
+		else
+			snprintf((char *)text, sizeof(text), "%6u  %s %02X%02X",
+				 record->cycle_count, name, record->design_checksum[1],
+				 record->design_checksum[0]);
+		dp_display_text(text);
+	}
+	if (found == DP_HISTORY_MAX_SHOWN)
+		dp_display_text("\r\n(older records not shown)");
+	if (key_type == DP_HISTORY_BY_DSN) {
+		/* The newest record with a cycle count */
+		for (index = 0u; index < found; index++) {
+			if (records[index].cycle_count == DP_HISTORY_NO_CYCLE_COUNT)
+				continue;
+			if (records[index].cycle_count + DP_HISTORY_CYCLE_MARGIN >=
+			    G5M_MAX_ALLOWED_PROGRAMMING_CYCLES) {
+				snprintf((char *)text, sizeof(text),
+					 "\r\n***** WARNING: %u of %u allowed programming cycles "
+					 "used *****",
+					 records[index].cycle_count,
+					 G5M_MAX_ALLOWED_PROGRAMMING_CYCLES);
+				dp_display_text(text);
+			}
+			break;
+		}
+	}
+	dp_display_text("\r\n");
+#else
+	(void)index;
+#endif
+	return (found != 0u) ? 0 : 1;
+}
+
+/*   *************** End of File *************** */
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dphistory.h                                             */
+/*                                                                          */
+/*  Description:    Contains function prototypes of the local programming   */
+/*  history, an append-only record of the actions run on each device       */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPHISTORY_H
+#define INC_DPHISTORY_H
+
+#include "dpuser.h"
+
+/*
+ * The history file starts with a header, followed by two hash tables and the records in the
+ * order they were appended.  Each table maps a bucket to the number (+ 1) of the newest record
+ * of the bucket, and every record links to the previous record of its bucket.  A lookup by DSN
+ * or by design name so reads only the records of one bucket, newest first, however long the
+ * history grows.  Records are never rewritten.
+ */
+#define DP_HISTORY_STORE	  "/var/cache/directc/history.db"
+#define DP_HISTORY_MAGIC	  0x31485044u /* "DPH1" */
+#define DP_HISTORY_HEADER_SIZE	  4096u
+#define DP_HISTORY_BUCKETS	  262144u
+#define DP_HISTORY_DSN_SIZE	  16u
+#define DP_HISTORY_DESIGN_SIZE	  30u
+#define DP_HISTORY_DIGEST_SIZE	  32u
+#define DP_HISTORY_NO_CYCLE_COUNT 0xffffu
+/* --history warns when a device is this close to G5M_MAX_ALLOWED_PROGRAMMING_CYCLES */
+#define DP_HISTORY_CYCLE_MARGIN 50u
+/* Records shown by --history */
+#define DP_HISTORY_MAX_SHOWN 20u
+
+#define DP_HISTORY_BY_DSN    0u
+#define DP_HISTORY_BY_DESIGN 1u
+
+struct dp_history_file_header {
+	unsigned int magic;
+	unsigned int record_size;
+	unsigned int buckets;
+	unsigned int records;
+};
+
+struct dp_history_record {
+	unsigned int previous_dsn;    /* Record number + 1 of the previous record of the bucket */
+	unsigned int previous_design; /* Same for the design bucket */
+	unsigned int time;	      /* Seconds since the epoch */
+	unsigned int duration_ms;
+	unsigned short cycle_count;   /* DP_HISTORY_NO_CYCLE_COUNT if not available */
+	unsigned char action;	      /* Action code, see dpalg.h */
+	unsigned char result;	      /* Error code of the action */
+	unsigned char dsn[DP_HISTORY_DSN_SIZE];
+	unsigned char design_name[DP_HISTORY_DESIGN_SIZE]; /* Padded with zeros */
+	unsigned char design_checksum[2];
+	unsigned char design_version[2];
+	unsigned char reserved[2];
+	unsigned char fabric_digest[DP_HISTORY_DIGEST_SIZE];
+	unsigned char snvm_digest[DP_HISTORY_DIGEST_SIZE];
+	unsigned char bitstream_digest[DP_HISTORY_DIGEST_SIZE]; /* Of the DAT file, zeros if none */
+};
+
+void dp_history_append(struct dp_history_record *record);
+unsigned long dp_history_find(unsigned char key_type, unsigned char *key,
+			      struct dp_history_record *records, unsigned long max_records);
+int dp_history_show(signed char *key);
+
+#endif /* INC_DPHISTORY_H */
+
+/*   *************** End of File *************** */
@@ -0,0 +1,770 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpimage.c                                               */
+/*                                                                          */
+/*  Description:    Contains functions to load DAT image files and to keep  */
+/*  recently used, CRC validated images resident between actions.           */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dpimage.h"
+#include "dpalg.h"
+#include "dpcom.h"
+#include "dpdecompress.h"
+#include "dpimagecheck.h"
+#include "dpreadahead.h"
+#include "dptimer.h"
+#include "dpuser.h"
+#include "dputil.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static struct dp_image resident_image_entries[DP_IMAGE_CACHE_ENTRIES];
+/* resident_image_entries, or a larger array made by dp_reserve_resident_images */
+static struct dp_image *resident_images = resident_image_entries;
+static unsigned int resident_image_count = DP_IMAGE_CACHE_ENTRIES;
+unsigned long resident_image_clock = 0u;
+struct dp_image *selected_image = (struct dp_image *)DPNULL;
+unsigned char dp_image_force_crc = FALSE;
+
+/*
+ * Module: dp_load_image_file
+ * 		purpose: Maps the DAT file into memory.  Pages are read on first access and
+ *		stay in the page cache shared with later invocations.  With USE_PAGING the file
+ *		is kept open instead and read one page at a time by dp_get_page_data.  Inputs
+ *		that cannot be mapped or paged, such as pipes, are read into system memory
+ *		with dp_read_image as the data arrives.  A path of "-" reads the standard input.
+ *		Compressed files are recognized by their first bytes and decompressed into
+ *		system memory by dp_decompress_image.
+ * Return value:
+ * 		DP_IMAGE_LOADED or the exit status describing why the file could not be loaded.
+ *
+ */
+static unsigned char dp_load_image_file(signed char *path, struct dp_image *image)
+{
+	struct stat file_stat;
+	void *mapping;
+	int fd;
+	unsigned char status = DP_IMAGE_LOADED;
+	unsigned char magic[DP_COMPRESSION_MAGIC_SIZE];
+	unsigned long magic_length = 0u;
+	unsigned char format;
+	ssize_t received;
+
+	memset(image, 0, sizeof(struct dp_image));
+	strncpy((char *)image->path, (char *)path, DP_IMAGE_PATH_SIZE - 1u);
+	image->fd = -1;
+
+	/* "-" is the standard input, e.g. an image piped from another program */
+	if (strcmp((char *)path, "-") == 0)
+		fd = dup(STDIN_FILENO);
+	else
+		fd = open((char *)path, O_RDONLY);
+	if (fd < 0) {
+#ifdef ENABLE_DISPLAY
+		dp_display_text("\r\nError: can't open file \n");
+		dp_display_text(path);
+#endif
+		return DP_IMAGE_OPEN_ERROR;
+	}
+
+	while (magic_length < DP_COMPRESSION_MAGIC_SIZE) {
+		received = read(fd, &magic[magic_length], DP_COMPRESSION_MAGIC_SIZE - magic_length);
+		if (received <= 0)
+			break;
+		magic_length += (unsigned long)received;
+	}
+	/* dp_get_resident_image compares the file with this to notice a rewrite */
+	if ((fstat(fd, &file_stat) == 0) && S_ISREG(file_stat.st_mode))
+		image->source = file_stat;
+
+	format = dp_compression_format(magic, magic_length);
+	if (format != DP_COMPRESSION_NONE) {
+		status = dp_decompress_image(fd, format, magic, magic_length, image);
+		if (status == DP_IMAGE_LOADED)
+			image->loaded = TRUE;
+		close(fd);
+		return status;
+	}
+
+	if ((fstat(fd, &file_stat) == 0) && S_ISREG(file_stat.st_mode) && (file_stat.st_size > 0)) {
+		image->size = file_stat.st_size;
+		if (strcmp((char *)path, "-") != 0) {
+			image->cache.magic = DP_IMAGE_CACHE_MAGIC;
+			image->cache.device = (unsigned long)file_stat.st_dev;
+			image->cache.inode = (unsigned long)file_stat.st_ino;
+			image->cache.size = (unsigned long)file_stat.st_size;
+			image->cache.mtime_sec = (unsigned long)file_stat.st_mtim.tv_sec;
+			image->cache.mtime_nsec = (unsigned long)file_stat.st_mtim.tv_nsec;
+		}
+#ifdef USE_PAGING
+		image->fd = fd;
+		image->loaded = TRUE;
+		return status;
+#endif
+		mapping = mmap(DPNULL, (size_t)image->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping != MAP_FAILED) {
+			/* The CRC check and the frame loop walk the image front to back */
+			madvise(mapping, (size_t)image->size, MADV_SEQUENTIAL);
+			madvise(mapping, (size_t)image->size, MADV_WILLNEED);
+			image->buffer = (unsigned char *)mapping;
+			image->mapped = TRUE;
+			image->loaded = TRUE;
+			close(fd);
+			return status;
+		}
+	}
+
+	status = dp_read_image(fd, magic, magic_length, image);
+	if (status == DP_IMAGE_LOADED)
+		image->loaded = TRUE;
+	close(fd);
+	return status;
+}
+
+/*
+ * Module: dp_image_sink_init
+ * 		purpose: Prepares sink to receive image, which must not have a buffer yet.  An
+ *		image that arrives as a stream is written into the sink in one pass.  Its buffer is
+ *		allocated with the size given in the header, and the image CRC is computed as the
+ *		bytes arrive, so that dp_check_image_crc does not walk the image again.
+ *
+ */
+void dp_image_sink_init(struct dp_image_sink *sink, struct dp_image *image)
+{
+	memset(sink, 0, sizeof(struct dp_image_sink));
+	sink->image = image;
+	return;
+}
+
+/*
+ * Module: dp_image_sink_space
+ * 		purpose: Returns where the next bytes of the image are to be written and how much
+ *		room there is.  The header is staged in the sink.  After that the output goes to the
+ *		image buffer, which is doubled if the header understated the image size.
+ * Return value:
+ * 		The output pointer, or DPNULL if memory ran out.
+ *
+ */
+unsigned char *dp_image_sink_space(struct dp_image_sink *sink, unsigned long *space)
+{
+	unsigned char *buffer;
+
+	if (sink->image->buffer == (unsigned char *)DPNULL) {
+		if (sink->length < DP_IMAGE_SIZE_FIELD_END) {
+			*space = DP_IMAGE_SIZE_FIELD_END - sink->length;
+			return &sink->header[sink->length];
+		}
+		sink->capacity = (sink->expected_size > sink->length) ? sink->expected_size
+									: DP_IMAGE_READ_CHUNK;
+		sink->image->buffer = (unsigned char *)dp_malloc(sink->capacity);
+		if (sink->image->buffer == (unsigned char *)DPNULL)
+			return (unsigned char *)DPNULL;
+		memcpy(sink->image->buffer, sink->header, sink->length);
+	}
+	if (sink->length == sink->capacity) {
+		buffer = (unsigned char *)dp_malloc(sink->capacity * 2u);
+		if (buffer == (unsigned char *)DPNULL)
+			return (unsigned char *)DPNULL;
+		memcpy(buffer, sink->image->buffer, sink->length);
+		dp_free(sink->image->buffer);
+		sink->image->buffer = buffer;
+		sink->capacity *= 2u;
+	}
+	*space = sink->capacity - sink->length;
+	return &sink->image->buffer[sink->length];
+}
+
+/*
+ * Module: dp_image_sink_written
+ * 		purpose: Accounts for count bytes written at the place returned by dp_sink_space
+ *		and adds the ones covered by the image CRC to it.
+ *
+ */
+void dp_image_sink_written(struct dp_image_sink *sink, unsigned char *data, unsigned long count)
+{
+	unsigned long magic;
+	unsigned long crc_length;
+
+	sink->length += count;
+	if ((sink->image->buffer == (unsigned char *)DPNULL) &&
+	    (sink->length == DP_IMAGE_SIZE_FIELD_END)) {
+		/* Same file signatures as dp_check_image_crc */
+		magic = (unsigned long)sink->header[0] | ((unsigned long)sink->header[1] << 8u) |
+			((unsigned long)sink->header[2] << 16u) |
+			((unsigned long)sink->header[3] << 24u);
+		if ((magic == 0x69736544u) || (magic == 0x65746341u) || (magic == 0x2D4D3447u) ||
+		    (magic == 0x34475452u) || (magic == 0x2D4D3547u)) {
+			sink->expected_size =
+			    (unsigned long)sink->header[IMAGE_SIZE_OFFSET] |
+			    ((unsigned long)sink->header[IMAGE_SIZE_OFFSET + 1u] << 8u) |
+			    ((unsigned long)sink->header[IMAGE_SIZE_OFFSET + 2u] << 16u) |
+			    ((unsigned long)sink->header[IMAGE_SIZE_OFFSET + 3u] << 24u);
+			if (sink->expected_size < MIN_IMAGE_SIZE)
+				sink->expected_size = 0u;
+		}
+		data = sink->header;
+		count = sink->length;
+	}
+	if (sink->expected_size != 0u) {
+		/* The CRC covers everything but the CRC stored in the last two bytes */
+		crc_length = sink->expected_size - 2u;
+		if (sink->length - count < crc_length) {
+			if (sink->length > crc_length)
+				count -= sink->length - crc_length;
+			sink->crc = dp_crc16_update(sink->crc, data, count);
+		}
+	}
+	return;
+}
+
+/*
+ * Module: dp_image_sink_finish
+ * 		purpose: Completes the image once all of it was written.
+ *		The image is marked as CRC checked if the CRC computed on the way matches.
+ * Return value:
+ * 		DP_IMAGE_LOADED, DP_IMAGE_MEMORY_ERROR or DP_IMAGE_READ_ERROR for an empty file.
+ *
+ */
+unsigned char dp_image_sink_finish(struct dp_image_sink *sink)
+{
+	struct dp_image *image = sink->image;
+	unsigned int stored_crc;
+
+	if (sink->length == 0u)
+		return DP_IMAGE_READ_ERROR;
+	if (image->buffer == (unsigned char *)DPNULL) {
+		/* Shorter than the header */
+		image->buffer = (unsigned char *)dp_malloc(sink->length);
+		if (image->buffer == (unsigned char *)DPNULL)
+			return DP_IMAGE_MEMORY_ERROR;
+		memcpy(image->buffer, sink->header, sink->length);
+	}
+	image->size = sink->length;
+	if ((sink->expected_size != 0u) && (sink->length >= sink->expected_size)) {
+		stored_crc = (unsigned int)image->buffer[sink->expected_size - 2u] |
+			     ((unsigned int)image->buffer[sink->expected_size - 1u] << 8u);
+		if (stored_crc == sink->crc)
+			image->crc_checked = TRUE;
+	}
+	return DP_IMAGE_LOADED;
+}
+
+
+#ifdef ENABLE_IMAGE_CACHE
+/*
+ * Module: dp_image_cache_hash
+ * 		purpose: Fills in the content hash of record: 64 bit FNV-1a over the first
+ *		DP_IMAGE_CACHE_HEADER_SIZE bytes of the image and its stored CRC.  They are read from
+ *		the file when the image is paged.
+ * Return value:
+ * 		TRUE, or FALSE if the image is too small or cannot be read.
+ *
+ */
+static unsigned char dp_image_cache_hash(struct dp_image *image,
+					 struct dp_image_cache_record *record)
+{
+	unsigned char header[DP_IMAGE_CACHE_HEADER_SIZE];
+	unsigned char crc[2];
+	unsigned char *data;
+	unsigned long length;
+	unsigned long index;
+	unsigned long long hash = 0xCBF29CE484222325ull;
+
+	if (image->size < MIN_IMAGE_SIZE)
+		return FALSE;
+	length = image->size - 2u;
+	if (length > DP_IMAGE_CACHE_HEADER_SIZE)
+		length = DP_IMAGE_CACHE_HEADER_SIZE;
+	if (image->buffer != (unsigned char *)DPNULL) {
+		data = image->buffer;
+		memcpy(crc, &image->buffer[image->size - 2u], 2u);
+	} else {
+		data = header;
+		if ((pread(image->fd, header, length, 0) != (ssize_t)length) ||
+		    (pread(image->fd, crc, 2u, (off_t)(image->size - 2u)) != 2))
+			return FALSE;
+	}
+	for (index = 0u; index < length; index++)
+		hash = (hash ^ data[index]) * 0x100000001B3ull;
+	hash = (hash ^ crc[0]) * 0x100000001B3ull;
+	hash = (hash ^ crc[1]) * 0x100000001B3ull;
+	record->content_hash = hash;
+	return TRUE;
+}
+
+/* The fields up to content_hash identify the file and its content */
+static unsigned char dp_image_cache_matches(struct dp_image_cache_record *record,
+					    struct dp_image_cache_record *image_record)
+{
+	return ((record->magic == image_record->magic) && (record->device == image_record->device) &&
+		(record->inode == image_record->inode) && (record->size == image_record->size) &&
+		(record->mtime_sec == image_record->mtime_sec) &&
+		(record->mtime_nsec == image_record->mtime_nsec) &&
+		(record->content_hash == image_record->content_hash))
+		   ? TRUE
+		   : FALSE;
+}
+
+static void dp_image_cache_path(struct dp_image *image, char *cache_path, size_t size)
+{
+	snprintf(cache_path, size, "%s%s", (char *)image->path, DP_IMAGE_CACHE_SUFFIX);
+	return;
+}
+
+/*
+ * Module: dp_image_cache_find
+ * 		purpose: Looks for the record of the image in the sidecar file, then in the store.
+ * Return value:
+ * 		TRUE with the record in found, or FALSE.
+ *
+ */
+static unsigned char dp_image_cache_find(struct dp_image *image,
+					 struct dp_image_cache_record *found)
+{
+	char cache_path[DP_IMAGE_PATH_SIZE + sizeof(DP_IMAGE_CACHE_SUFFIX)];
+	unsigned char status = FALSE;
+	int fd;
+
+	dp_image_cache_path(image, cache_path, sizeof(cache_path));
+	fd = open(cache_path, O_RDONLY);
+	if (fd >= 0) {
+		if ((read(fd, found, sizeof(*found)) == (ssize_t)sizeof(*found)) &&
+		    (dp_image_cache_matches(found, &image->cache) == TRUE))
+			status = TRUE;
+		close(fd);
+		if (status == TRUE)
+			return status;
+	}
+
+	fd = open(DP_IMAGE_CACHE_STORE, O_RDONLY);
+	if (fd < 0)
+		return status;
+	flock(fd, LOCK_SH);
+	while (read(fd, found, sizeof(*found)) == (ssize_t)sizeof(*found)) {
+		if (dp_image_cache_matches(found, &image->cache) == TRUE) {
+			status = TRUE;
+			break;
+		}
+	}
+	close(fd);
+	return status;
+}
+
+/*
+ * Module: dp_image_cache_lookup
+ * 		purpose: Marks the image as CRC checked if the sidecar file or the store records a
+ *		passed check of the same file.  The file identity must match, and so must the hash of
+ *		the header region and of the stored CRC.  Records that do not match are ignored.
+ *
+ */
+static void dp_image_cache_lookup(struct dp_image *image)
+{
+	struct dp_image_cache_record record;
+
+	if ((dp_image_force_crc == TRUE) || (image->cache.magic != DP_IMAGE_CACHE_MAGIC) ||
+	    (dp_image_cache_hash(image, &image->cache) == FALSE))
+		return;
+	if (dp_image_cache_find(image, &record) == TRUE) {
+		image->crc_checked = TRUE;
+		image->crc_cached = TRUE;
+		image->cache.check_ms = record.check_ms;
+	}
+	return;
+}
+
+/*
+ * Module: dp_image_cache_store_record
+ * 		purpose: Writes the record of the image into the store, replacing the record of the
+ *		same file, or else the least recently written record once the store is full.
+ *		Concurrent runs are serialized with flock.
+ *
+ */
+static void dp_image_cache_store_record(struct dp_image *image)
+{
+	struct dp_image_cache_record record;
+	char directory[sizeof(DP_IMAGE_CACHE_STORE)];
+	unsigned long slot = 0u;
+	unsigned long oldest = 0u;
+	unsigned long index = 0u;
+	unsigned long sequence = 0u;
+	unsigned char same_file = FALSE;
+	int fd;
+
+	strcpy(directory, DP_IMAGE_CACHE_STORE);
+	*strrchr(directory, '/') = '\0';
+	mkdir(directory, 0755);
+	fd = open(DP_IMAGE_CACHE_STORE, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+		return;
+	flock(fd, LOCK_EX);
+	while ((index < DP_IMAGE_CACHE_STORE_ENTRIES) &&
+	       (read(fd, &record, sizeof(record)) == (ssize_t)sizeof(record))) {
+		if (record.sequence > sequence)
+			sequence = record.sequence;
+		if ((same_file == FALSE) && (record.device == image->cache.device) &&
+		    (record.inode == image->cache.inode)) {
+			same_file = TRUE;
+			slot = index;
+		}
+		if ((same_file == FALSE) && ((index == 0u) || (record.sequence < oldest))) {
+			oldest = record.sequence;
+			slot = index;
+		}
+		index++;
+	}
+	/* A free entry is used before the least recently written one */
+	if ((same_file == FALSE) && (index < DP_IMAGE_CACHE_STORE_ENTRIES))
+		slot = index;
+	image->cache.sequence = sequence + 1u;
+	if (pwrite(fd, &image->cache, sizeof(image->cache),
+		   (off_t)(slot * sizeof(image->cache))) != (ssize_t)sizeof(image->cache))
+		ftruncate(fd, (off_t)(slot * sizeof(image->cache)));
+	close(fd);
+	return;
+}
+
+/*
+ * Module: dp_image_cache_store
+ * 		purpose: Records the passed CRC check of the image in its sidecar file and in the
+ *		store.  Failing to write them, e.g. in a read-only directory, only means that the
+ *		next run checks the CRC again.
+ *
+ */
+static void dp_image_cache_store(struct dp_image *image, unsigned long check_ms)
+{
+	char cache_path[DP_IMAGE_PATH_SIZE + sizeof(DP_IMAGE_CACHE_SUFFIX)];
+	char temporary[DP_IMAGE_PATH_SIZE + sizeof(DP_IMAGE_CACHE_SUFFIX) + 12u];
+	unsigned char failed;
+	int fd;
+
+	if ((image->cache.magic != DP_IMAGE_CACHE_MAGIC) ||
+	    (dp_image_cache_hash(image, &image->cache) == FALSE))
+		return;
+	image->cache.check_ms = check_ms;
+
+	/*
+	 * Written under a temporary name and renamed, so that an interrupted or concurrent
+	 * write never leaves a torn sidecar.  The name ends with the suffix so that bundles
+	 * ignore it.
+	 */
+	dp_image_cache_path(image, cache_path, sizeof(cache_path));
+	if (snprintf(temporary, sizeof(temporary), "%s.%d%s", (char *)image->path, (int)getpid(),
+		     DP_IMAGE_CACHE_SUFFIX) < (int)sizeof(temporary)) {
+		fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd >= 0) {
+			failed = (write(fd, &image->cache, sizeof(image->cache)) !=
+				  (ssize_t)sizeof(image->cache)) ? TRUE : FALSE;
+			if ((close(fd) != 0) || (failed == TRUE) ||
+			    (rename(temporary, cache_path) != 0))
+				unlink(temporary);
+		}
+	}
+	dp_image_cache_store_record(image);
+	return;
+}
+#endif
+
+/*
+ * Module: dp_load_image
+ * 		purpose: Loads the DAT file with dp_load_image_file.  With ENABLE_IMAGE_CACHE the
+ *		CRC check is skipped if the sidecar file or the store shows that this file passed
+ *		it before, unless dp_image_force_crc is set.
+ * Return value:
+ * 		DP_IMAGE_LOADED or the exit status describing why the file could not be loaded.
+ *
+ */
+unsigned char dp_load_image(signed char *path, struct dp_image *image)
+{
+	unsigned long long start = dp_timer_ns();
+	unsigned char status;
+
+	status = dp_load_image_file(path, image);
+#ifdef ENABLE_IMAGE_CACHE
+	if ((status == DP_IMAGE_LOADED) && (image->crc_checked == FALSE))
+		dp_image_cache_lookup(image);
+#endif
+	image->load_ns = dp_timer_ns() - start;
+	return status;
+}
+
+/*
+ * Module: dp_read_image
+ * 		purpose: Reads the input into system memory until end of file, in chunks as they
+ *		arrive.  prefix holds the bytes already read from fd.  The image CRC is computed
+ *		on the way.
+ * Return value:
+ * 		DP_IMAGE_LOADED, DP_IMAGE_MEMORY_ERROR or DP_IMAGE_READ_ERROR.
+ *
+ */
+unsigned char dp_read_image(int fd, unsigned char *prefix, unsigned long prefix_length,
+			    struct dp_image *image)
+{
+	struct dp_image_sink sink;
+	unsigned char *buffer;
+	unsigned long space;
+	ssize_t received;
+	unsigned char status = DP_IMAGE_LOADED;
+	unsigned long long start = dp_timer_ns();
+
+	dp_image_sink_init(&sink, image);
+	for (;;) {
+		buffer = dp_image_sink_space(&sink, &space);
+		if (buffer == (unsigned char *)DPNULL) {
+#ifdef ENABLE_DISPLAY
+			dp_display_text("\r\nError: can't allocate memory (");
+			dp_display_value(sink.capacity / 1024, DEC);
+			dp_display_text(" Kbytes)\n");
+#endif
+			status = DP_IMAGE_MEMORY_ERROR;
+			break;
+		}
+		if (prefix_length != 0u) {
+			received = (ssize_t)((prefix_length < space) ? prefix_length : space);
+			memcpy(buffer, prefix, (size_t)received);
+			prefix += received;
+			prefix_length -= (unsigned long)received;
+		} else {
+			received = read(fd, buffer, (size_t)space);
+		}
+		if (received == 0)
+			status = dp_image_sink_finish(&sink);
+		if ((received < 0) || (status == DP_IMAGE_READ_ERROR)) {
+#ifdef ENABLE_DISPLAY
+			dp_display_text("\r\nError reading file \n");
+			dp_display_text(image->path);
+#endif
+			status = DP_IMAGE_READ_ERROR;
+			break;
+		}
+		if (received == 0)
+			break;
+		dp_image_sink_written(&sink, buffer, (unsigned long)received);
+	}
+	if (status != DP_IMAGE_LOADED) {
+		if (image->buffer != (unsigned char *)DPNULL)
+			dp_free(image->buffer);
+		image->buffer = (unsigned char *)DPNULL;
+		image->size = 0u;
+	}
+	image->load_ns = dp_timer_ns() - start;
+	return status;
+}
+
+void dp_unload_image(struct dp_image *image)
+{
+#ifdef ENABLE_BACKGROUND_CRC
+	dp_image_check_cancel(image);
+#endif
+	if (image->buffer != (unsigned char *)DPNULL) {
+		if (image->mapped == TRUE)
+			munmap(image->buffer, (size_t)image->size);
+		else
+			dp_free(image->buffer);
+	}
+	if ((image->loaded == TRUE) && (image->fd >= 0)) {
+#ifdef USE_READ_AHEAD
+		if (image_fd == image->fd)
+			dp_read_ahead_invalidate();
+#endif
+		close(image->fd);
+	}
+	memset(image, 0, sizeof(struct dp_image));
+	return;
+}
+
+/*
+ * Module: dp_select_image
+ * 		purpose: Points the data access functions in dpcom.c at the given image.
+ *		The block address cache is reset since it refers to the previous image.
+ *
+ */
+void dp_select_image(struct dp_image *image)
+{
+	selected_image = image;
+	image_buffer = image->buffer;
+#ifdef USE_PAGING
+	image_fd = image->fd;
+#endif
+	image_size = image->size;
+	image_crc_checked = image->crc_checked;
+	dp_init_com_vars();
+	return;
+}
+
+/*
+ * Module: dp_deselect_image
+ * 		purpose: Leaves the data access functions without an image, for the actions that
+ *		run without a DAT file, see dp_image_required.
+ *
+ */
+void dp_deselect_image(void)
+{
+	selected_image = (struct dp_image *)DPNULL;
+	image_buffer = (unsigned char *)DPNULL;
+#ifdef USE_PAGING
+	image_fd = -1;
+#endif
+	image_size = MIN_IMAGE_SIZE;
+	image_crc_checked = FALSE;
+	dp_init_com_vars();
+	return;
+}
+
+/*
+ * Module: dp_image_crc_verified
+ * 		purpose: Called when the CRC check of the selected image passed after check_ms.  The
+ *		image keeps the result, and with ENABLE_IMAGE_CACHE so do its sidecar file and the
+ *		store.
+ *
+ */
+void dp_image_crc_verified(unsigned long check_ms)
+{
+	if ((selected_image == (struct dp_image *)DPNULL) || (selected_image->crc_checked == TRUE))
+		return;
+	selected_image->crc_checked = TRUE;
+#ifdef ENABLE_IMAGE_CACHE
+	dp_image_cache_store(selected_image, check_ms);
+#endif
+	return;
+}
+
+/*
+ * Module: dp_image_source_unchanged
+ * 		purpose: Compares the file of a resident image with the file it was loaded from.
+ *		Any write changes the modification time, which is compared to the nanosecond, and
+ *		a file replaced by rename has a new inode.
+ * Return value:
+ * 		TRUE if the resident image still holds the content of the file.
+ *
+ */
+static unsigned char dp_image_source_unchanged(struct dp_image *image, struct stat *file_stat)
+{
+	return ((image->source.st_ino != 0) && (image->source.st_dev == file_stat->st_dev) &&
+		(image->source.st_ino == file_stat->st_ino) &&
+		(image->source.st_size == file_stat->st_size) &&
+		(image->source.st_mtim.tv_sec == file_stat->st_mtim.tv_sec) &&
+		(image->source.st_mtim.tv_nsec == file_stat->st_mtim.tv_nsec))
+		   ? TRUE
+		   : FALSE;
+}
+
+/*
+ * Module: dp_get_resident_image
+ * 		purpose: Returns the resident copy of the image file, loading and CRC checking
+ *		it first if it is not resident or if the file changed since it was loaded.  The
+ *		least recently used entry is replaced when all entries are in use.
+ * Return value:
+ * 		Pointer to the resident image or DPNULL.  status holds the dp_load_image exit
+ *		status or DP_IMAGE_CRC_ERROR.
+ *
+ */
+struct dp_image *dp_get_resident_image(signed char *path, unsigned char *status)
+{
+	struct stat file_stat;
+	struct dp_image *image = (struct dp_image *)DPNULL;
+	unsigned int index;
+
+	*status = DP_IMAGE_LOADED;
+	resident_image_clock++;
+	if (stat((char *)path, &file_stat) != 0) {
+#ifdef ENABLE_DISPLAY
+		dp_display_text("\r\nError: can't open file \n");
+		dp_display_text(path);
+#endif
+		*status = DP_IMAGE_OPEN_ERROR;
+		return image;
+	}
+
+	for (index = 0u; index < resident_image_count; index++) {
+		if ((resident_images[index].loaded == TRUE) &&
+		    (strcmp((char *)resident_images[index].path, (char *)path) == 0)) {
+			if (dp_image_source_unchanged(&resident_images[index], &file_stat) == TRUE) {
+				resident_images[index].last_used = resident_image_clock;
+				return &resident_images[index];
+			}
+			/*
+			 * The file changed on disk.  The resident copy is stale, and a mapping of a
+			 * file rewritten in place holds bytes that were never CRC checked.
+			 */
+			dp_unload_image(&resident_images[index]);
+		}
+	}
+
+	image = &resident_images[0];
+	for (index = 1u; index < resident_image_count; index++) {
+		if (resident_images[index].last_used < image->last_used)
+			image = &resident_images[index];
+	}
+	dp_unload_image(image);
+
+	*status = dp_load_image(path, image);
+	if (*status == DP_IMAGE_LOADED) {
+		dp_select_image(image);
+		error_code = DPE_SUCCESS;
+		dp_check_image_crc();
+		if (error_code == DPE_SUCCESS) {
+			image->crc_checked = TRUE;
+			image->last_used = resident_image_clock;
+		} else {
+			*status = DP_IMAGE_CRC_ERROR;
+		}
+	}
+	if (*status != DP_IMAGE_LOADED) {
+		dp_unload_image(image);
+		image = (struct dp_image *)DPNULL;
+	}
+	return image;
+}
+
+/*
+ * Module: dp_reserve_resident_images
+ * 		purpose: Makes room for count resident images, so that a caller that knows every
+ *		file it will use, like the batch runner, never has one replaced and checked again.
+ *		The resident images are released first.  dp_release_resident_images returns to
+ *		DP_IMAGE_CACHE_ENTRIES entries.
+ * Return value:
+ * 		TRUE, or FALSE if the entries could not be allocated.
+ *
+ */
+unsigned char dp_reserve_resident_images(unsigned int count)
+{
+	struct dp_image *images;
+
+	if (count <= resident_image_count)
+		return TRUE;
+	dp_release_resident_images();
+	images = (struct dp_image *)dp_malloc(count * sizeof(struct dp_image));
+	if (images == (struct dp_image *)DPNULL)
+		return FALSE;
+	memset(images, 0, count * sizeof(struct dp_image));
+	resident_images = images;
+	resident_image_count = count;
+	return TRUE;
+}
+
+void dp_release_resident_images(void)
+{
+	unsigned int index;
+	for (index = 0u; index < resident_image_count; index++) {
+		dp_unload_image(&resident_images[index]);
+	}
+	if (resident_images != resident_image_entries) {
+		dp_free(resident_images);
+		resident_images = resident_image_entries;
+		resident_image_count = DP_IMAGE_CACHE_ENTRIES;
+	}
+	return;
+}
+
+/*   *************** End of File *************** */
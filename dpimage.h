@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpimage.h                                               */
+/*                                                                          */
+/*  Description:    Contains function prototypes needed to load DAT image  */
+/*  files and to keep recently used images resident in memory               */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPIMAGE_H
+#define INC_DPIMAGE_H
+
+#include <sys/stat.h>
+#include <time.h>
+
+/* Number of images kept resident by dp_get_resident_image, see dp_reserve_resident_images */
+#define DP_IMAGE_CACHE_ENTRIES 4u
+#define DP_IMAGE_PATH_SIZE     256u
+/* Initial buffer size when the size of the input is not known, e.g. a pipe */
+#define DP_IMAGE_READ_CHUNK    65536u
+
+/* A streamed image is staged up to the end of its image size field (IMAGE_SIZE_OFFSET + 4) */
+#define DP_IMAGE_SIZE_FIELD_END 29u
+
+/*
+ * Passed CRC checks are recorded in a sidecar file next to the DAT file and in a store shared
+ * by all DAT files, see dp_image_cache_lookup.  The store also covers DAT files in read-only
+ * directories.  It holds DP_IMAGE_CACHE_STORE_ENTRIES records, the least recently written one is
+ * replaced.
+ */
+#define DP_IMAGE_CACHE_SUFFIX	      ".dpcache"
+#define DP_IMAGE_CACHE_STORE	      "/var/cache/directc/crc.store"
+#define DP_IMAGE_CACHE_STORE_ENTRIES 256u
+#define DP_IMAGE_CACHE_MAGIC	      0x32435044u /* "DPC2" */
+/* Bytes at the start of the image that are hashed with the stored CRC: the header, the block
+ * directory and the start of the first block */
+#define DP_IMAGE_CACHE_HEADER_SIZE    4096u
+
+/* Exit status values reported by dp_load_image */
+#define DP_IMAGE_LOADED		 0u
+#define DP_IMAGE_OPEN_ERROR	 103u
+#define DP_IMAGE_MEMORY_ERROR	 104u
+#define DP_IMAGE_READ_ERROR	 105u
+#define DP_IMAGE_REQUIRED_ERROR	 106u
+#define DP_IMAGE_CRC_ERROR	 107u
+#define DP_IMAGE_NO_MATCH	 111u /* No file of a bundle was built for the device */
+#define DP_IMAGE_AMBIGUOUS	 112u /* More than one file of a bundle matches the device */
+
+/* Identifies the file and the content of an image.  magic is 0 if the image is not a file */
+struct dp_image_cache_record {
+	unsigned long magic;
+	unsigned long device;
+	unsigned long inode;
+	unsigned long size;
+	unsigned long mtime_sec;
+	unsigned long mtime_nsec;
+	unsigned long long content_hash; /* Hash of the header region and of the stored CRC */
+	unsigned long check_ms;		  /* Duration of the CRC check that passed */
+	unsigned long sequence;		  /* Order of the writes to the store, see dp_image_cache_store_record */
+};
+
+struct dp_image {
+	signed char path[DP_IMAGE_PATH_SIZE];
+	unsigned long size;
+	struct stat source; /* The file as it was loaded, st_ino is 0 for a stream */
+	unsigned char *buffer;
+	unsigned char loaded;
+	unsigned char mapped;	   /* buffer is a read-only mapping of the file */
+	int fd;			   /* File read on demand when paging, otherwise -1 */
+	unsigned char crc_checked; /* Set once dp_check_image_crc passed on this buffer */
+	unsigned long last_used;
+	struct dp_image_cache_record cache; /* File identity filled in by dp_load_image */
+	unsigned char crc_cached;	    /* crc_checked was taken from the sidecar or the store */
+	unsigned long long load_ns;	    /* Time taken to load, reported by the next action */
+};
+
+/* Writes an image that arrives as a stream into its buffer, see dp_image_sink_init */
+struct dp_image_sink {
+	struct dp_image *image;
+	unsigned long capacity;
+	unsigned long length;
+	unsigned long expected_size; /* Image size from the header, 0 if not a DAT file */
+	unsigned int crc;
+	unsigned char header[DP_IMAGE_SIZE_FIELD_END];
+};
+
+extern struct dp_image *selected_image; /* Image selected with dp_select_image */
+extern unsigned char dp_image_force_crc; /* Ignore the recorded CRC checks (--force-crc) */
+
+unsigned char dp_load_image(signed char *path, struct dp_image *image);
+unsigned char dp_read_image(int fd, unsigned char *prefix, unsigned long prefix_length,
+			    struct dp_image *image);
+void dp_image_sink_init(struct dp_image_sink *sink, struct dp_image *image);
+unsigned char *dp_image_sink_space(struct dp_image_sink *sink, unsigned long *space);
+void dp_image_sink_written(struct dp_image_sink *sink, unsigned char *data, unsigned long count);
+unsigned char dp_image_sink_finish(struct dp_image_sink *sink);
+void dp_unload_image(struct dp_image *image);
+void dp_select_image(struct dp_image *image);
+void dp_deselect_image(void);
+void dp_image_crc_verified(unsigned long check_ms);
+struct dp_image *dp_get_resident_image(signed char *path, unsigned char *status);
+unsigned char dp_reserve_resident_images(unsigned int count);
+void dp_release_resident_images(void);
+
+#endif /* INC_DPIMAGE_H */
+
+/*   *************** End of File *************** */
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpimagecheck.c                                          */
+/*                                                                          */
+/*  Description:    Background CRC check.  A mapped or paged image is only  */
+/*  read from the storage as it is used, so the CRC pass is what actually   */
+/*  loads it.  The pass runs in a thread while the main thread claims the   */
+/*  GPIO lines, reads IDCODE and waits for the device to be ready.          */
+/*  dp_check_image_crc then only collects the result.                       */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dpimagecheck.h"
+#include "dpuser.h"
+#include "dpalg.h"
+#include "dpcom.h"
+#include "dptimer.h"
+#include "dputil.h"
+
+#ifdef ENABLE_BACKGROUND_CRC
+#include <pthread.h>
+#include <unistd.h>
+
+/* One check runs at a time, for the image of the action started from the command line */
+static struct dp_image *image_check_image = (struct dp_image *)DPNULL;
+static pthread_t image_check_thread;
+/* Set by dp_image_check_cancel, protected by image_check_lock */
+static pthread_mutex_t image_check_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned char image_check_cancel = FALSE;
+static unsigned long image_check_length; /* Bytes covered by the CRC */
+static unsigned int image_check_crc;
+static unsigned long image_check_ms; /* Time the thread took */
+static unsigned char image_check_complete;
+
+/*
+ * Module: dp_image_check_read
+ * 		purpose: Reads length bytes of the image at offset.  A paged image is read with
+ *		pread, which leaves the file position used by dp_get_page_data alone.
+ * Return value:
+ * 		Pointer to the bytes, or DPNULL if they could not be read.
+ *
+ */
+static unsigned char *dp_image_check_read(struct dp_image *image, unsigned char *buffer,
+					  unsigned long offset, unsigned long length)
+{
+	unsigned long done = 0u;
+	ssize_t received;
+
+	if (image->buffer != (unsigned char *)DPNULL)
+		return &image->buffer[offset];
+	while (done < length) {
+		received = pread(image->fd, &buffer[done], length - done, (off_t)(offset + done));
+		if (received <= 0)
+			return (unsigned char *)DPNULL;
+		done += (unsigned long)received;
+	}
+	return buffer;
+}
+
+static void *dp_image_check_thread(void *argument)
+{
+	struct dp_image *image = (struct dp_image *)argument;
+	unsigned char *buffer = (unsigned char *)DPNULL;
+	unsigned char *data;
+	unsigned long offset = 0u;
+	unsigned long length;
+	unsigned int crc = 0u;
+	unsigned char cancel = FALSE;
+	unsigned long start = dp_timer_ms();
+
+	if (image->buffer == (unsigned char *)DPNULL) {
+		buffer = (unsigned char *)dp_malloc(DP_IMAGE_CHECK_CHUNK);
+		if (buffer == (unsigned char *)DPNULL)
+			return (void *)DPNULL;
+	}
+	while ((offset < image_check_length) && (cancel == FALSE)) {
+		length = image_check_length - offset;
+		if (length > DP_IMAGE_CHECK_CHUNK)
+			length = DP_IMAGE_CHECK_CHUNK;
+		data = dp_image_check_read(image, buffer, offset, length);
+		if (data == (unsigned char *)DPNULL)
+			break;
+		crc = dp_crc16_update(crc, data, length);
+		offset += length;
+
+		pthread_mutex_lock(&image_check_lock);
+		cancel = image_check_cancel;
+		pthread_mutex_unlock(&image_check_lock);
+	}
+	if (buffer != (unsigned char *)DPNULL)
+		dp_free(buffer);
+	/* Read by the main thread after pthread_join */
+	image_check_crc = crc;
+	image_check_ms = dp_timer_ms() - start;
+	image_check_complete = (offset == image_check_length) ? TRUE : FALSE;
+	return (void *)DPNULL;
+}
+
+/*
+ * Module: dp_image_check_needed
+ * 		purpose: Tells the actions that check the image CRC before using the image data, as
+ *		dp_perform_G5_action does, from the ones that never read it.
+ * Return value:
+ * 		TRUE if Action_code checks the CRC.
+ *
+ */
+static unsigned char dp_image_check_needed(void)
+{
+	return ((Action_code == DP_ERASE_ACTION_CODE) || (Action_code == DP_PROGRAM_ACTION_CODE) ||
+		(Action_code == DP_PROGRAM_IF_DIFFERENT_ACTION_CODE) ||
+		(Action_code == DP_VERIFY_ACTION_CODE) ||
+		(Action_code == DP_ENC_DATA_AUTHENTICATION_ACTION_CODE) ||
+		(Action_code == DP_VERIFY_DIGEST_ACTION_CODE))
+		   ? TRUE
+		   : FALSE;
+}
+
+/*
+ * Module: dp_image_check_start
+ * 		purpose: Starts the CRC check of a DAT file that was mapped or opened for paging and
+ *		has not passed the check before, if Action_code needs it.  Images that are not DAT
+ *		files, that are shorter than their header says, or that were checked while being
+ *		read are left to dp_check_image_crc.
+ * Return value:
+ * 		None.  Without the thread dp_check_image_crc computes the CRC itself.
+ *
+ */
+void dp_image_check_start(struct dp_image *image)
+{
+	unsigned char buffer[DP_IMAGE_SIZE_FIELD_END];
+	unsigned char *header;
+	unsigned long signature;
+	unsigned long size;
+
+	if ((dp_image_check_needed() == FALSE) ||
+	    (image_check_image != (struct dp_image *)DPNULL) || (image->loaded == FALSE) ||
+	    (image->crc_checked == TRUE) || ((image->mapped == FALSE) && (image->fd < 0)) ||
+	    (image->size < MIN_IMAGE_SIZE))
+		return;
+	header = dp_image_check_read(image, buffer, 0u, DP_IMAGE_SIZE_FIELD_END);
+	if (header == (unsigned char *)DPNULL)
+		return;
+	signature = (unsigned long)header[0] | ((unsigned long)header[1] << 8u) |
+		    ((unsigned long)header[2] << 16u) | ((unsigned long)header[3] << 24u);
+	size = (unsigned long)header[IMAGE_SIZE_OFFSET] |
+	       ((unsigned long)header[IMAGE_SIZE_OFFSET + 1u] << 8u) |
+	       ((unsigned long)header[IMAGE_SIZE_OFFSET + 2u] << 16u) |
+	       ((unsigned long)header[IMAGE_SIZE_OFFSET + 3u] << 24u);
+	if (!((signature == 0x69736544u) || (signature == 0x65746341u) ||
+	      (signature == 0x2D4D3447u) || (signature == 0x34475452u) ||
+	      (signature == 0x2D4D3547u)) ||
+	    (size < MIN_IMAGE_SIZE) || (size > image->size))
+		return;
+
+	image_check_length = size - 2u;
+	image_check_complete = FALSE;
+	image_check_cancel = FALSE;
+	if (pthread_create(&image_check_thread, (pthread_attr_t *)DPNULL, dp_image_check_thread,
+			   image) == 0)
+		image_check_image = image;
+	return;
+}
+
+/*
+ * Module: dp_image_check_wait
+ * 		purpose: Waits for the background check of image to finish.
+ * Return value:
+ * 		TRUE with the CRC of the image in crc and the time the thread took in check_ms, or
+ *		FALSE if no check of image ran to the end, in which case the caller computes the CRC
+ *		itself.
+ *
+ */
+unsigned char dp_image_check_wait(struct dp_image *image, unsigned int *crc,
+				  unsigned long *check_ms)
+{
+	unsigned long start;
+
+	if ((image == (struct dp_image *)DPNULL) || (image_check_image != image))
+		return FALSE;
+	start = dp_timer_ms();
+	pthread_join(image_check_thread, (void **)DPNULL);
+	image_check_image = (struct dp_image *)DPNULL;
+	if (image_check_complete == FALSE)
+		return FALSE;
+#ifdef ENABLE_DISPLAY
+	dp_display_text("\r\nCRC was computed in the background, waited ");
+	dp_display_value(dp_timer_ms() - start, DEC);
+	dp_display_text(" ms.");
+#endif
+	*crc = image_check_crc;
+	*check_ms = image_check_ms;
+	return TRUE;
+}
+
+/*
+ * Module: dp_image_check_cancel
+ * 		purpose: Stops the background check of image, if any, before the image is unloaded,
+ *		e.g. when the action did not need the CRC.
+ *
+ */
+void dp_image_check_cancel(struct dp_image *image)
+{
+	if (image_check_image != image)
+		return;
+	pthread_mutex_lock(&image_check_lock);
+	image_check_cancel = TRUE;
+	pthread_mutex_unlock(&image_check_lock);
+	pthread_join(image_check_thread, (void **)DPNULL);
+	image_check_image = (struct dp_image *)DPNULL;
+	return;
+}
+#endif
+
+/*   *************** End of File *************** */
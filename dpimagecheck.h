@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpimagecheck.h                                          */
+/*                                                                          */
+/*  Description:    Contains function prototypes of the thread that checks  */
+/*  the image CRC while the device is being identified                      */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPIMAGECHECK_H
+#define INC_DPIMAGECHECK_H
+
+#include "dpimage.h"
+
+/* Bytes of the image added to the CRC at a time, between checks for cancellation */
+#define DP_IMAGE_CHECK_CHUNK 1048576u
+
+#ifdef ENABLE_BACKGROUND_CRC
+void dp_image_check_start(struct dp_image *image);
+unsigned char dp_image_check_wait(struct dp_image *image, unsigned int *crc,
+				  unsigned long *check_ms);
+void dp_image_check_cancel(struct dp_image *image);
+#endif
+
+#endif /* INC_DPIMAGECHECK_H */
+
+/*   *************** End of File *************** */
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dploop.c                                                */
+/*                                                                          */
+/*  Description:    Hot-plug loop.  Polls IDCODE until a PolarFire device   */
+/*  is connected, runs the action with the resident DAT image, then waits   */
+/*  for the board to be removed before looking for the next one.            */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dploop.h"
+
+#ifdef ENABLE_LOOP_SUPPORT
+#include "dpG5alg.h"
+#include "dpalg.h"
+#include "dpbundle.h"
+#include "dpcom.h"
+#include "dpimage.h"
+#include "dpjtag.h"
+#include "dptimer.h"
+
+#include <signal.h>
+#include <stdio.h>
+
+volatile sig_atomic_t loop_stop_requested = 0;
+
+static void dp_loop_interrupt(int signal_number)
+{
+	/* Let the current board finish.  A second interrupt cancels it. */
+	loop_stop_requested = 1;
+	signal(signal_number, dp_timer_interrupt);
+}
+
+#ifdef ENABLE_DISPLAY
+static void dp_loop_quiet(signed char *text)
+{
+	(void)text;
+}
+#endif
+
+/*
+ * Module: dp_run_loop
+ * 		purpose: Loads and CRC checks the DAT file once, then runs the action on every
+ *		board connected to the fixture until interrupted.  If pFileName is a bundle
+ *		directory, the file is picked for each board by its IDCODE and stays resident
+ *		for the next boards of the same part.  Without pFileName only the actions of
+ *		dp_image_required that need no DAT file run.
+ * Return value:
+ * 		0 if all the boards passed, otherwise the last error code.
+ *
+ */
+int dp_run_loop(struct gpio_handle *jtag_gpio, signed char *pAction, signed char *pFileName)
+{
+	struct dp_image *image = (struct dp_image *)DPNULL;
+	signed char bundle_file[DP_IMAGE_PATH_SIZE];
+	unsigned char bundle;
+	unsigned char status;
+	unsigned char iExecResult;
+	unsigned int boards = 0u;
+	unsigned int passed = 0u;
+	int exit_status = DPE_SUCCESS;
+	unsigned long start_time;
+	long elapsed_ms;
+	long total_ms = 0;
+	unsigned long board_ID;
+
+	Action_code = DP_NO_ACTION_FOUND;
+	if (pAction != (signed char *)DPNULL)
+		Action_code = dp_get_Action_code(pAction);
+	if (Action_code == DP_NO_ACTION_FOUND) {
+		printf("Error: Invalid action.\n");
+		return DPE_ACTION_NOT_FOUND;
+	}
+	if ((pFileName == (signed char *)DPNULL) && (dp_image_required(Action_code) == TRUE)) {
+		printf("Error: Dat file is required...\n");
+		return DP_IMAGE_REQUIRED_ERROR;
+	}
+	bundle = (pFileName != (signed char *)DPNULL) ? dp_is_image_bundle(pFileName) : FALSE;
+	if ((pFileName != (signed char *)DPNULL) && (bundle == FALSE)) {
+		image = dp_get_resident_image(pFileName, &status);
+		if (image == (struct dp_image *)DPNULL)
+			return status;
+	}
+
+	signal(SIGINT, dp_loop_interrupt);
+	printf("\r\nWaiting for a device. Press Ctrl-C to stop.\n");
+	fflush(stdout);
+
+	while (dp_loop_wait_for_device(jtag_gpio, TRUE) == TRUE) {
+		board_ID = device_ID;
+		boards++;
+		printf("\r\n===== Board %u: IDCODE %08lX =====", boards, board_ID);
+		fflush(stdout);
+
+		start_time = dp_timer_ms();
+		if (bundle == TRUE) {
+			image = (struct dp_image *)DPNULL;
+			status = dp_find_bundle_image(pFileName, board_ID, device_rev, bundle_file);
+			if (status == DP_IMAGE_LOADED)
+				image = dp_get_resident_image(bundle_file, &status);
+		}
+		if (pFileName == (signed char *)DPNULL) {
+			dp_deselect_image();
+			Action_code = dp_get_Action_code(pAction);
+			iExecResult = dp_top(jtag_gpio);
+		} else if (image != (struct dp_image *)DPNULL) {
+			dp_select_image(image);
+			Action_code = dp_get_Action_code(pAction);
+			iExecResult = dp_top(jtag_gpio);
+		} else {
+			iExecResult = status;
+		}
+		elapsed_ms = (long)(dp_timer_ms() - start_time);
+		total_ms += elapsed_ms;
+
+		if (iExecResult == DPE_SUCCESS) {
+			passed++;
+			printf("\r\nBoard %u: IDCODE %08lX PASS in %ld ms\n", boards, board_ID,
+			       elapsed_ms);
+		} else {
+			exit_status = iExecResult;
+			printf("\r\nBoard %u: IDCODE %08lX FAIL error code %u in %ld ms\n", boards,
+			       board_ID, iExecResult, elapsed_ms);
+		}
+		printf("Remove the board.\n");
+		fflush(stdout);
+		if (dp_loop_wait_for_device(jtag_gpio, FALSE) == FALSE)
+			break;
+	}
+
+	printf("\r\nBoards: %u passed: %u failed: %u average: %ld ms\n", boards, passed,
+	       boards - passed, (boards != 0u) ? total_ms / boards : 0L);
+	signal(SIGINT, SIG_DFL);
+	dp_release_resident_images();
+	return exit_status;
+}
+
+/*
+ * Module: dp_loop_device_present
+ * 		purpose: Reads IDCODE without display output.
+ * Return value:
+ * 		TRUE if a PolarFire family device answers.
+ *
+ */
+unsigned char dp_loop_device_present(struct gpio_handle *jtag_gpio)
+{
+#ifdef ENABLE_DISPLAY
+	void (*display_hook)(signed char *text) = dp_display_hook;
+
+	dp_display_hook = dp_loop_quiet;
+#endif
+	goto_jtag_state(jtag_gpio, JTAG_TEST_LOGIC_RESET, 0u);
+	dp_read_idcode(jtag_gpio);
+#ifdef ENABLE_DISPLAY
+	dp_display_hook = display_hook;
+#endif
+
+	return ((device_ID & G5M_FAMILY_MASK) == G5M_FAMILY) ? TRUE : FALSE;
+}
+
+/*
+ * Module: dp_loop_wait_for_device
+ * 		purpose: Polls until the device is seen as present (or absent) on
+ *		DP_LOOP_SETTLE_POLLS consecutive reads.
+ * Return value:
+ * 		FALSE if the loop was interrupted while waiting.
+ *
+ */
+unsigned char dp_loop_wait_for_device(struct gpio_handle *jtag_gpio, unsigned char present)
+{
+	unsigned int matches = 0u;
+
+	while (loop_stop_requested == 0) {
+		if (dp_loop_device_present(jtag_gpio) == present)
+			matches++;
+		else
+			matches = 0u;
+		if (matches == DP_LOOP_SETTLE_POLLS)
+			return TRUE;
+		dp_delay(DP_LOOP_POLL_INTERVAL);
+	}
+	return FALSE;
+}
+#endif /* ENABLE_LOOP_SUPPORT */
+
+/*   *************** End of File *************** */
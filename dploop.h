@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dploop.h                                                */
+/*                                                                          */
+/*  Description:    Contains function prototypes of the hot-plug loop which */
+/*  programs every board connected to the fixture                           */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPLOOP_H
+#define INC_DPLOOP_H
+
+#include "dpuser.h"
+
+#ifdef ENABLE_LOOP_SUPPORT
+/* IDCODE poll interval while waiting for a board to be connected or removed */
+#define DP_LOOP_POLL_INTERVAL 250000u
+/* Number of consecutive matching polls needed before a change is accepted.  This
+ * rides over contact bounce while the board is inserted or pulled. */
+#define DP_LOOP_SETTLE_POLLS 2u
+
+int dp_run_loop(struct gpio_handle *jtag_gpio, signed char *pAction, signed char *pFileName);
+unsigned char dp_loop_device_present(struct gpio_handle *jtag_gpio);
+unsigned char dp_loop_wait_for_device(struct gpio_handle *jtag_gpio, unsigned char present);
+#endif
+
+#endif /* INC_DPLOOP_H */
+
+/*   *************** End of File *************** */
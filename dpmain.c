@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpmain.c                                                */
+/*                                                                          */
+/*  Description:    Command line front end of directc_programmer built on   */
+/*                  top of libdirectc                                       */
+/*                                                                          */
+/****************************************************************************/
+#include "dpuser.h"
+#include "dpalg.h"
+#include "dpbatch.h"
+#include "dpbundle.h"
+#include "dpcom.h"
+#include "dpdaemon.h"
+#include "dphistory.h"
+#include "dpimage.h"
+#include "dpimagecheck.h"
+#include "dploop.h"
+#include "dpmetrics.h"
+#include "dptimer.h"
+
+#include <ctype.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void displayActions()
+{
+	printf("Usage: directc_programmer [-h] [-a<action>] [-d<socket>] [-m<manifest>] [--loop] [--timeout=<ms>] [--force-crc] [--history=<DSN|design>] [--metrics=<file>] [filename | directory | -]\n");
+	printf("-a<action>, Performs required action\n");
+	printf("Available actions:\n");
+	printf("\tprogram                 - Performs erase, program, and verify operations for supported blocks in data file\n");
+	printf("\tprogram_if_different    - Performs program unless the device holds the digests recorded when it was last programmed with the data file\n");
+	printf("\terase                   - Erases supported blocks in data file\n");
+	printf("\tread_idcode             - Reads and displays the content of the IDCODE register\n");
+	printf("\tverify                  - Performs verify operation for supported blocks in data file\n");
+	printf("\tdevice_info             - Displays device design information and status, including security settings\n");
+	printf("\tenc_data_authentication - Performs data authentication for array to make sure data was encrypted with same encryption key as the device\n");
+	printf("\tverify_digest           - PolarFire specific action\n");
+	printf("\tvalidate_user_enc_keys  - Validates user encryption keys\n");
+	printf("\tread_device_certificate - Reads and displays device certificate\n");
+	printf("\tzeroize_like_new        - Performs zeroization. Device is recoverable\n");
+	printf("\tzeroize_unrecoverable   - Performs zeroization. Device is not recoverable\n");
+	printf("\tspi_flash_read_idcode   - Returns 3 bytes ID data as a response to RDID (9Fh) instruction\n");
+	printf("\tspi_flash_read          - Reads entire content of the SPI-Flash memory device. This operation could be extremely slow depending on how the read data is transmitted to host\n");
+	printf("\tspi_flash_erase         - Erases entire content of the SPI-Flash memory device\n");
+	printf("\tspi_flash_program       - Determines sectors needed to store the loaded image and then performs erasing of sectors followed by programming the image\n");
+	printf("\tspi_flash_verify        - Verifies device content against loaded image. Only memory region occupied by loaded image is verified\n");
+	printf("\tspi_flash_blank_check   - Verifies entire memory space of device is 0xFFh. This action can be very slow but is useful for debugging purposes\n");
+	printf("\tdat_info                - Decodes and checks the data files without a device attached. Takes more than one filename\n\n");
+	printf("-h, Print this message\n");
+	printf("-, Reads the DAT file from the standard input instead of a file\n");
+	printf("directory, Reads IDCODE first and uses the DAT file of the directory built for the device\n");
+#ifdef ENABLE_DAEMON_SUPPORT
+	printf("-d<socket>, Claims the GPIO lines once and serves action requests on the Unix socket\n");
+#endif
+#ifdef ENABLE_BATCH_SUPPORT
+	printf("-m<manifest>, Runs the steps listed in the manifest file in order\n");
+#endif
+#ifdef ENABLE_LOOP_SUPPORT
+	printf("--loop, Runs the action on every device connected to the fixture until Ctrl-C\n");
+#endif
+	printf("--timeout=<ms>, Abandons an action that runs longer than the given time\n");
+	printf("--operation-timeout=<ms>, Abandons an action when a single device poll takes longer than the given time\n");
+	printf("--force-crc, Checks the CRC of the DAT file even if it passed the check before\n");
+#ifdef ENABLE_METRICS
+	printf("--metrics=<file>, Writes the counters and phase times of each action to the file, in the Prometheus textfile format if it ends with .prom, otherwise as JSON\n");
+#endif
+#ifdef ENABLE_HISTORY
+	printf("--history=<DSN|design>, Shows the recorded actions of a device, given its DSN as 32 hex digits, or of a design\n");
+#endif
+	printf("Ctrl-C cancels the action in progress and reports the time spent in each phase\n");
+	printf("\n");
+
+	printf("This program is built for arm-linux-gnueabihf-gcc \n");
+}
+
+/*
+ * Module: dp_dat_info_files
+ * 		purpose: Runs the dat_info action on every filename of the command line.  The GPIO
+ *		lines are not claimed.
+ * Return value:
+ * 		0 if no problem was found, otherwise the result of the last file that failed.
+ *
+ */
+static signed int dp_dat_info_files(int argc, char **argv, struct gpio_handle *jtag_gpio)
+{
+	signed int iArg;
+	signed int iResult;
+	signed int iExitStatus = 0;
+	unsigned int uiFiles = 0u;
+	unsigned int uiFailed = 0u;
+	struct dp_image image;
+
+	/* dat_info reads every image in full, see dp_dat_info_crc */
+	dp_image_force_crc = TRUE;
+	memset(&image, 0, sizeof(image));
+	for (iArg = 1; iArg < argc; iArg++) {
+		if ((argv[iArg][0] == '-') && (argv[iArg][1] != '\0'))
+			continue;
+		uiFiles++;
+		printf("\r\n%s:", argv[iArg]);
+		iResult = dp_load_image(argv[iArg], &image);
+		if (iResult == DP_IMAGE_LOADED) {
+			dp_select_image(&image);
+			iResult = dp_top(jtag_gpio);
+		}
+		dp_unload_image(&image);
+		if (iResult != DPE_SUCCESS) {
+			uiFailed++;
+			iExitStatus = iResult;
+		}
+		printf("\n");
+	}
+	if (uiFiles == 0u) {
+		printf("\r\nError: Dat file is required...\n");
+		return DP_IMAGE_REQUIRED_ERROR;
+	}
+	printf("%u file(s) checked, %u with problems\n", uiFiles, uiFailed);
+	return iExitStatus;
+}
+
+int main(int argc, char **argv)
+{
+	signed int iExitStatus = 0;
+	signed int iArg;
+	signed char *pAction = (signed char *)DPNULL;
+	signed char *pFileName = (signed char *)DPNULL;
+#ifdef ENABLE_DAEMON_SUPPORT
+	signed char *pDaemonSocket = (signed char *)DPNULL;
+#endif
+#ifdef ENABLE_BATCH_SUPPORT
+	signed char *pManifest = (signed char *)DPNULL;
+#endif
+#ifdef ENABLE_HISTORY
+	signed char *pHistoryKey = (signed char *)DPNULL;
+#endif
+	signed char BundleFileName[DP_IMAGE_PATH_SIZE];
+	unsigned char bGPIOConfigured = FALSE;
+#ifdef ENABLE_LOOP_SUPPORT
+	unsigned char bLoop = FALSE;
+#endif
+	unsigned char bDATFileExists = FALSE;
+	struct dp_image image;
+	signed int iExecResult = DPE_SUCCESS;
+	time_t start_time;
+	time_t end_time;
+	signed int iTimeDelta;
+	struct gpio_handle *jtag_gpio = malloc(sizeof(struct gpio_handle));
+	
+	memset(jtag_gpio, 0, sizeof(struct gpio_handle));
+	memset(&image, 0, sizeof(image));
+	for (iArg = 1; iArg < argc; iArg++) {
+		if ((argv[iArg][0] == '-') && (argv[iArg][1] != '\0')) {
+			switch (toupper(argv[iArg][1])) {
+				case 'A': /* set action name */
+					pAction = &argv[iArg][2];
+					if ((argc < 3) &&
+					    (dp_image_required(dp_get_Action_code(pAction)) == TRUE)) {
+#ifdef ENABLE_DISPLAY
+						dp_display_text("-a<action> : specify action name\r\n\n");
+						displayActions();
+#endif
+					return -1;
+					}
+					break;
+				case 'H':
+					displayActions();
+					return 0;
+					break;
+#ifdef ENABLE_DAEMON_SUPPORT
+				case 'D': /* serve requests on a Unix socket */
+					pDaemonSocket = &argv[iArg][2];
+					break;
+#endif
+#ifdef ENABLE_BATCH_SUPPORT
+				case 'M': /* run the steps of a manifest file */
+					pManifest = &argv[iArg][2];
+					break;
+#endif
+#ifdef ENABLE_LOOP_SUPPORT
+				case 'L': /* program every board connected to the fixture */
+					bLoop = TRUE;
+					break;
+#endif
+				case '-': /* long options */
+					if (strncmp(&argv[iArg][2], "timeout=", 8) == 0) {
+						dp_action_time_budget =
+						    strtoul(&argv[iArg][10], (char **)DPNULL, 0);
+					} else if (strncmp(&argv[iArg][2], "operation-timeout=", 18) == 0) {
+						dp_operation_time_budget =
+						    strtoul(&argv[iArg][20], (char **)DPNULL, 0);
+					} else if (strcmp(&argv[iArg][2], "force-crc") == 0) {
+						dp_image_force_crc = TRUE;
+#ifdef ENABLE_METRICS
+					} else if (strncmp(&argv[iArg][2], "metrics=", 8) == 0) {
+						dp_metrics_path = &argv[iArg][10];
+#endif
+#ifdef ENABLE_HISTORY
+					} else if (strncmp(&argv[iArg][2], "history=", 8) == 0) {
+						pHistoryKey = &argv[iArg][10];
+#endif
+#ifdef ENABLE_LOOP_SUPPORT
+					} else if (strcmp(&argv[iArg][2], "loop") == 0) {
+						bLoop = TRUE;
+#endif
+					} else {
+						printf("Invalid option\n");
+					}
+					break;
+				default:
+					printf("Invalid option\n");
+			}
+		} else {
+			/* it's a filename, or - for the standard input */
+			pFileName = argv[iArg];
+		}
+	} 
+
+#ifdef ENABLE_HISTORY
+	/* The history is read from the local store, the device is not accessed */
+	if (pHistoryKey != (signed char *)DPNULL)
+		return dp_history_show(pHistoryKey);
+#endif
+#ifdef ENABLE_DAEMON_SUPPORT
+	if (pDaemonSocket != (signed char *)DPNULL) {
+		iExitStatus = -1;
+		if (gpio_config(jtag_gpio) == 0)
+			iExitStatus = dp_run_daemon(jtag_gpio, pDaemonSocket);
+		gpio_release(jtag_gpio);
+		free(jtag_gpio);
+		return iExitStatus;
+	}
+#endif
+	signal(SIGINT, dp_timer_interrupt);
+#ifdef ENABLE_BATCH_SUPPORT
+	if (pManifest != (signed char *)DPNULL) {
+		iExitStatus = -1;
+		if (gpio_config(jtag_gpio) == 0)
+			iExitStatus = dp_run_batch(jtag_gpio, pManifest);
+		gpio_release(jtag_gpio);
+		free(jtag_gpio);
+		return iExitStatus;
+	}
+#endif
+#ifdef ENABLE_LOOP_SUPPORT
+	if (bLoop == TRUE) {
+		iExitStatus = -1;
+		if (gpio_config(jtag_gpio) == 0)
+			iExitStatus = dp_run_loop(jtag_gpio, pAction, pFileName);
+		gpio_release(jtag_gpio);
+		free(jtag_gpio);
+		return iExitStatus;
+	}
+#endif
+	if ((pAction != (signed char *)DPNULL) &&
+	    (dp_get_Action_code(pAction) == DP_DAT_INFO_ACTION_CODE)) {
+		Action_code = DP_DAT_INFO_ACTION_CODE;
+		iExitStatus = dp_dat_info_files(argc, argv, jtag_gpio);
+		free(jtag_gpio);
+		return iExitStatus;
+	}
+
+	if ((pFileName != (signed char *)DPNULL)) {
+		bDATFileExists = TRUE;
+		if (dp_is_image_bundle(pFileName) == TRUE) {
+			/* Only the file built for the connected device is loaded */
+			iExitStatus = gpio_config(jtag_gpio);
+			bGPIOConfigured = TRUE;
+			if (iExitStatus == 0)
+				iExitStatus = dp_resolve_bundle(jtag_gpio, pFileName, BundleFileName);
+			pFileName = BundleFileName;
+		}
+		if (iExitStatus == 0)
+			iExitStatus = dp_load_image(pFileName, &image);
+	}
+	if (iExitStatus == 0) {
+
+		/*
+		 *    Execute the directc program
+		 */
+		if (bDATFileExists == TRUE)
+			dp_select_image(&image);
+		Action_code = dp_get_Action_code(pAction);
+#ifdef ENABLE_BACKGROUND_CRC
+		/* The CRC is checked while the GPIO lines are claimed and the device identified */
+		if (bDATFileExists == TRUE)
+			dp_image_check_start(&image);
+#endif
+		if ((bDATFileExists == FALSE) && (dp_image_required(Action_code) == TRUE)) {
+			time(&start_time);
+			printf("\r\nError: Dat file is required...\n");
+			iExecResult = DP_IMAGE_REQUIRED_ERROR;
+			time(&end_time);
+		} else {
+			time(&start_time);
+			if ((bGPIOConfigured == FALSE) && (gpio_config(jtag_gpio) != 0))
+				iExecResult = -1;
+			else
+				iExecResult = dp_top(jtag_gpio);
+			time(&end_time);
+		}
+
+		if (iExecResult != DPE_SUCCESS) {
+#ifdef ENABLE_DISPLAY
+			dp_display_text("\r\nError return code ");
+			dp_display_value(iExecResult, DEC);
+#endif
+		} else {
+#ifdef ENABLE_DISPLAY
+			dp_display_text("\r\nExit code = 0... Success\n");
+#endif
+		}
+
+		/*
+		 *    Print out elapsed time
+		 */
+		iTimeDelta = (int)(end_time - start_time);
+#ifdef ENABLE_DISPLAY
+		printf("\r\nElapsed time = %02u:%02u:%02u", iTimeDelta / 3600, /* hours */
+			 (iTimeDelta % 3600) / 60,				 /* minutes */
+			 iTimeDelta % 60);					 /* seconds */
+#endif
+		/*
+		 *    Print out elapsed time
+		 */
+
+		printf(" Done.\n");
+}
+
+	dp_unload_image(&image);
+	gpio_release(jtag_gpio);
+	free(jtag_gpio);
+	return (iExitStatus);
+}
+
+/* *************** End of File *************** */
@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpmetrics.c                                             */
+/*                                                                          */
+/*  Description:    Run metrics.  Counts the JTAG traffic of an action and  */
+/*  writes it, with the time of each phase, for collection by monitoring.  */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dpmetrics.h"
+#include "dpalg.h"
+#include "dpimage.h"
+#include "dptimer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+struct dp_metrics dp_metrics;
+signed char *dp_metrics_path = (signed char *)DPNULL;
+
+void dp_metrics_reset(void)
+{
+	memset(&dp_metrics, 0, sizeof(dp_metrics));
+	return;
+}
+
+/* Accounts for a device poll loop that ran with poll_opcode in the instruction register */
+void dp_metrics_poll(unsigned char poll_opcode, unsigned long iterations,
+		     unsigned long long elapsed_ns)
+{
+	dp_metrics.opcodes[poll_opcode].polls++;
+	dp_metrics.opcodes[poll_opcode].iterations += iterations;
+	dp_metrics.opcodes[poll_opcode].poll_ns += elapsed_ns;
+	return;
+}
+
+/* Accounts for a frame of component (1 based) shifted into the device */
+void dp_metrics_frame(unsigned int component)
+{
+	if ((component != 0u) && (component <= DP_METRICS_MAX_COMPONENTS))
+		dp_metrics.component_frames[component - 1u]++;
+	return;
+}
+
+static unsigned int dp_metrics_components(void)
+{
+	unsigned int components = DP_METRICS_MAX_COMPONENTS;
+
+	while ((components > 0u) && (dp_metrics.component_frames[components - 1u] == 0u))
+		components--;
+	return components;
+}
+
+static void dp_metrics_write_json(FILE *file)
+{
+	unsigned int index;
+	unsigned int components;
+	const char *separator = "";
+
+	fprintf(file, "{\n");
+	fprintf(file, "  \"action\": \"%s\",\n", (char *)dp_get_Action_name(Action_code));
+	fprintf(file, "  \"result\": %u,\n", error_code);
+	fprintf(file, "  \"exit_code\": %u,\n", unique_exit_code);
+	fprintf(file, "  \"idcode\": \"%08lX\",\n", device_ID);
+	fprintf(file, "  \"timestamp\": %lu,\n", (unsigned long)time((time_t *)DPNULL));
+	fprintf(file, "  \"duration_seconds\": %.9f,\n", (double)dp_timer_total_ns() / 1e9);
+	fprintf(file, "  \"tck_cycles\": %llu,\n", dp_metrics.tck_cycles);
+	fprintf(file, "  \"gpio_writes\": %llu,\n", dp_metrics.gpio_writes);
+	fprintf(file, "  \"gpio_reads\": %llu,\n", dp_metrics.gpio_reads);
+	fprintf(file, "  \"ir_scans\": %llu,\n", dp_metrics.ir_scans);
+	fprintf(file, "  \"dr_scans\": %llu,\n", dp_metrics.dr_scans);
+	fprintf(file, "  \"bits_shifted\": %llu,\n", dp_metrics.bits_shifted);
+	fprintf(file, "  \"spi_bytes_programmed\": %llu,\n", dp_metrics.spi_bytes_programmed);
+	fprintf(file, "  \"spi_bytes_verified\": %llu,\n", dp_metrics.spi_bytes_verified);
+
+	fprintf(file, "  \"component_frames\": [");
+	components = dp_metrics_components();
+	for (index = 0u; index < components; index++)
+		fprintf(file, "%s%lu", (index == 0u) ? "" : ", ", dp_metrics.component_frames[index]);
+	fprintf(file, "],\n");
+
+	fprintf(file, "  \"polls\": [");
+	for (index = 0u; index < DP_METRICS_OPCODES; index++) {
+		if (dp_metrics.opcodes[index].polls == 0u)
+			continue;
+		fprintf(file,
+			"%s\n    {\"opcode\": \"0x%02X\", \"polls\": %lu, \"iterations\": %lu, "
+			"\"seconds\": %.9f}",
+			separator, index, dp_metrics.opcodes[index].polls,
+			dp_metrics.opcodes[index].iterations,
+			(double)dp_metrics.opcodes[index].poll_ns / 1e9);
+		separator = ",";
+	}
+	fprintf(file, "\n  ],\n");
+
+	fprintf(file, "  \"phases\": [");
+	for (index = 0u; index < timer_phase_count; index++) {
+		fprintf(file, "%s\n    {\"name\": \"%s\", \"seconds\": %.9f}",
+			(index == 0u) ? "" : ",", (char *)timer_phases[index].name,
+			(double)timer_phases[index].elapsed_ns / 1e9);
+	}
+	fprintf(file, "\n  ]\n}\n");
+	return;
+}
+
+static void dp_metrics_write_gauge(FILE *file, const char *name, const char *help,
+				   unsigned long long value)
+{
+	fprintf(file, "# HELP directc_%s %s\n# TYPE directc_%s gauge\n", name, help, name);
+	fprintf(file, "directc_%s{action=\"%s\"} %llu\n", name,
+		(char *)dp_get_Action_name(Action_code), value);
+	return;
+}
+
+static void dp_metrics_write_prometheus(FILE *file)
+{
+	char *action = (char *)dp_get_Action_name(Action_code);
+	unsigned int index;
+	unsigned int components;
+
+	dp_metrics_write_gauge(file, "action_result", "Error code of the last action.", error_code);
+	dp_metrics_write_gauge(file, "action_exit_code", "Unique exit code of the last action.",
+			       unique_exit_code);
+	dp_metrics_write_gauge(file, "action_timestamp_seconds", "End time of the last action.",
+			       (unsigned long long)time((time_t *)DPNULL));
+	fprintf(file, "# HELP directc_action_duration_seconds Duration of the last action.\n");
+	fprintf(file, "# TYPE directc_action_duration_seconds gauge\n");
+	fprintf(file, "directc_action_duration_seconds{action=\"%s\"} %.9f\n", action,
+		(double)dp_timer_total_ns() / 1e9);
+	dp_metrics_write_gauge(file, "tck_cycles", "TCK cycles of the last action.",
+			       dp_metrics.tck_cycles);
+	dp_metrics_write_gauge(file, "gpio_writes", "GPIO line writes of the last action.",
+			       dp_metrics.gpio_writes);
+	dp_metrics_write_gauge(file, "gpio_reads", "GPIO line reads of the last action.",
+			       dp_metrics.gpio_reads);
+	dp_metrics_write_gauge(file, "ir_scans", "IR scans of the last action.",
+			       dp_metrics.ir_scans);
+	dp_metrics_write_gauge(file, "dr_scans", "DR scans of the last action.",
+			       dp_metrics.dr_scans);
+	dp_metrics_write_gauge(file, "bits_shifted", "Bits shifted by the IR and DR scans of the "
+			       "last action.", dp_metrics.bits_shifted);
+	dp_metrics_write_gauge(file, "spi_bytes_programmed",
+			       "SPI flash bytes programmed by the last action.",
+			       dp_metrics.spi_bytes_programmed);
+	dp_metrics_write_gauge(file, "spi_bytes_verified",
+			       "SPI flash bytes verified by the last action.",
+			       dp_metrics.spi_bytes_verified);
+
+	components = dp_metrics_components();
+	if (components != 0u) {
+		fprintf(file, "# HELP directc_component_frames Frames of each component shifted "
+			      "by the last action.\n# TYPE directc_component_frames gauge\n");
+		for (index = 0u; index < components; index++)
+			fprintf(file, "directc_component_frames{action=\"%s\",component=\"%u\"} %lu\n",
+				action, index + 1u, dp_metrics.component_frames[index]);
+	}
+
+	fprintf(file, "# HELP directc_poll_loops Device poll loops of the last action.\n"
+		      "# TYPE directc_poll_loops gauge\n");
+	for (index = 0u; index < DP_METRICS_OPCODES; index++) {
+		if (dp_metrics.opcodes[index].polls != 0u)
+			fprintf(file, "directc_poll_loops{action=\"%s\",opcode=\"0x%02X\"} %lu\n",
+				action, index, dp_metrics.opcodes[index].polls);
+	}
+	fprintf(file, "# HELP directc_poll_iterations Status reads of the device poll loops of "
+		      "the last action.\n# TYPE directc_poll_iterations gauge\n");
+	for (index = 0u; index < DP_METRICS_OPCODES; index++) {
+		if (dp_metrics.opcodes[index].polls != 0u)
+			fprintf(file, "directc_poll_iterations{action=\"%s\",opcode=\"0x%02X\"} %lu\n",
+				action, index, dp_metrics.opcodes[index].iterations);
+	}
+	fprintf(file, "# HELP directc_poll_seconds Time spent in the device poll loops of the "
+		      "last action.\n# TYPE directc_poll_seconds gauge\n");
+	for (index = 0u; index < DP_METRICS_OPCODES; index++) {
+		if (dp_metrics.opcodes[index].polls != 0u)
+			fprintf(file, "directc_poll_seconds{action=\"%s\",opcode=\"0x%02X\"} %.9f\n",
+				action, index, (double)dp_metrics.opcodes[index].poll_ns / 1e9);
+	}
+
+	fprintf(file, "# HELP directc_phase_seconds Time of each phase of the last action.\n"
+		      "# TYPE directc_phase_seconds gauge\n");
+	for (index = 0u; index < timer_phase_count; index++) {
+		fprintf(file, "directc_phase_seconds{action=\"%s\",phase=\"%s\"} %.9f\n", action,
+			(char *)timer_phases[index].name,
+			(double)timer_phases[index].elapsed_ns / 1e9);
+	}
+	return;
+}
+
+/*
+ * Module: dp_metrics_write
+ * 		purpose: Writes the metrics of the action that just ended to path, in the Prometheus
+ *		textfile format if the name ends with DP_METRICS_PROMETHEUS_SUFFIX, otherwise as
+ *		JSON.  The file is written under a temporary name and renamed, so that a collector
+ *		never reads it half written.
+ * Return value:
+ * 		TRUE if the file was written.
+ *
+ */
+unsigned char dp_metrics_write(signed char *path)
+{
+	char temporary[DP_IMAGE_PATH_SIZE + 8u];
+	size_t length = strlen((char *)path);
+	size_t suffix_length = strlen(DP_METRICS_PROMETHEUS_SUFFIX);
+	FILE *file;
+	int failed;
+
+	if (snprintf(temporary, sizeof(temporary), "%s.tmp", (char *)path) >= (int)sizeof(temporary))
+		return FALSE;
+	file = fopen(temporary, "w");
+	if (file == (FILE *)DPNULL)
+		return FALSE;
+	if ((length >= suffix_length) &&
+	    (strcmp((char *)path + length - suffix_length, DP_METRICS_PROMETHEUS_SUFFIX) == 0))
+		dp_metrics_write_prometheus(file);
+	else
+		dp_metrics_write_json(file);
+	failed = ferror(file);
+	if ((fclose(file) != 0) || (failed != 0) || (rename(temporary, (char *)path) != 0)) {
+		unlink(temporary);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*   *************** End of File *************** */
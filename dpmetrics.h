@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpmetrics.h                                             */
+/*                                                                          */
+/*  Description:    Contains function prototypes of the run metrics, the    */
+/*  counters of the JTAG traffic of an action exported as JSON or in the    */
+/*  Prometheus textfile format                                              */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPMETRICS_H
+#define INC_DPMETRICS_H
+
+#include "dpuser.h"
+
+/*
+ * The counters are plain increments of a global structure, cleared by dp_top when an action
+ * starts.  Only the thread that drives the JTAG lines updates them, so no lock is needed.
+ */
+#define DP_METRICS_MAX_COMPONENTS 64u
+#define DP_METRICS_OPCODES	  256u
+/* Files ending with this suffix are written in the Prometheus textfile format, others as JSON */
+#define DP_METRICS_PROMETHEUS_SUFFIX ".prom"
+
+struct dp_metrics_opcode {
+	unsigned long polls;	    /* Poll loops run with this opcode */
+	unsigned long iterations;   /* Status reads of these loops */
+	unsigned long long poll_ns; /* Time spent in these loops */
+};
+
+struct dp_metrics {
+	unsigned long long tck_cycles;
+	unsigned long long gpio_writes;
+	unsigned long long gpio_reads;
+	unsigned long long ir_scans;
+	unsigned long long dr_scans;
+	unsigned long long bits_shifted; /* Bits of the IR and DR scans */
+	unsigned long long spi_bytes_programmed;
+	unsigned long long spi_bytes_verified;
+	unsigned long component_frames[DP_METRICS_MAX_COMPONENTS];
+	struct dp_metrics_opcode opcodes[DP_METRICS_OPCODES];
+};
+
+extern struct dp_metrics dp_metrics;
+/* Written by dp_top after every action when set (--metrics) */
+extern signed char *dp_metrics_path;
+
+#ifdef ENABLE_METRICS
+#define DP_METRICS_ADD(counter, count) (dp_metrics.counter += (count))
+#else
+#define DP_METRICS_ADD(counter, count)
+#endif
+
+void dp_metrics_reset(void);
+void dp_metrics_poll(unsigned char poll_opcode, unsigned long iterations,
+		     unsigned long long elapsed_ns);
+void dp_metrics_frame(unsigned int component);
+unsigned char dp_metrics_write(signed char *path);
+
+#endif /* INC_DPMETRICS_H */
+
+/*   *************** End of File *************** */
@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpreadahead.c                                           */
+/*                                                                          */
+/*  Description:    Read-ahead thread of the USE_PAGING page cache.  Once   */
+/*  two page misses follow each other, the thread reads the next pages of   */
+/*  the image into a ring so that the shift loops find them loaded instead  */
+/*  of waiting on the storage.                                              */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dpreadahead.h"
+#include "dpuser.h"
+#include "dpalg.h"
+
+#if defined(USE_PAGING) && defined(USE_READ_AHEAD)
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Distance between the start addresses of consecutive pages of the stream */
+#define READ_AHEAD_STRIDE (PAGE_CACHE_PAGE_SIZE - MIN_VALID_BYTES_IN_PAGE)
+
+struct dp_read_ahead_slot {
+	unsigned long generation;
+	unsigned long start_address;
+	unsigned long length;
+	unsigned char end_of_stream; /* Nothing follows this slot in its generation */
+	unsigned char data[PAGE_CACHE_PAGE_SIZE];
+};
+
+/*
+ * Single producer, single consumer ring.  Each side owns its index.  The semaphores count the
+ * free and filled slots and carry the memory ordering between the two sides, so a page that is
+ * already loaded is taken with a single sem_trywait.  Neither sem_trywait nor sem_post takes a
+ * lock, they only enter the kernel to wake or put to sleep the side that has nothing to do.
+ */
+struct dp_read_ahead_slot read_ahead_ring[READ_AHEAD_DEPTH];
+sem_t read_ahead_free;
+sem_t read_ahead_filled;
+unsigned long read_ahead_head; /* Next slot taken by the consumer */
+unsigned char read_ahead_started = FALSE;
+
+/* Stream requested from the thread, protected by read_ahead_lock.  Only the consumer
+ * changes it.  A new generation makes the slots of the previous stream stale.  The lock is
+ * taken by the thread around the read of each slot, and by the consumer only to change the
+ * stream. */
+pthread_mutex_t read_ahead_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t read_ahead_wake = PTHREAD_COND_INITIALIZER;
+pthread_cond_t read_ahead_idle = PTHREAD_COND_INITIALIZER;
+unsigned char read_ahead_busy = FALSE; /* The thread is reading from read_ahead_fd */
+unsigned long read_ahead_generation = 0u;
+int read_ahead_fd = -1;
+unsigned long read_ahead_start;
+unsigned long read_ahead_end;
+
+/* Consumer side state */
+unsigned char read_ahead_active = FALSE; /* The current stream has not ended */
+unsigned long read_ahead_next;		  /* Start address of the next slot of the stream */
+unsigned long read_ahead_miss_end;	  /* End of the last page read synchronously */
+
+unsigned long read_ahead_hits = 0u;
+unsigned long read_ahead_stalls = 0u;
+unsigned long read_ahead_sync_reads = 0u;
+unsigned long read_ahead_low_water = READ_AHEAD_DEPTH;
+
+static void *dp_read_ahead_thread(void *argument)
+{
+	struct dp_read_ahead_slot *slot;
+	unsigned long tail = 0u;
+	unsigned long generation = 0u;
+	unsigned long address = 0u;
+	unsigned long end = 0u;
+	unsigned long length;
+	unsigned char done = TRUE;
+	int fd = -1;
+	ssize_t received;
+
+	(void)argument;
+	for (;;) {
+		while (sem_wait(&read_ahead_free) != 0) {
+		}
+
+		pthread_mutex_lock(&read_ahead_lock);
+		while ((done == TRUE) && (generation == read_ahead_generation))
+			pthread_cond_wait(&read_ahead_wake, &read_ahead_lock);
+		if (generation != read_ahead_generation) {
+			generation = read_ahead_generation;
+			fd = read_ahead_fd;
+			address = read_ahead_start;
+			end = read_ahead_end;
+			done = FALSE;
+		}
+		read_ahead_busy = TRUE;
+		pthread_mutex_unlock(&read_ahead_lock);
+
+		slot = &read_ahead_ring[tail % READ_AHEAD_DEPTH];
+		slot->generation = generation;
+		slot->start_address = address;
+		slot->length = 0u;
+		length = (address < end) ? end - address : 0u;
+		if (length > PAGE_CACHE_PAGE_SIZE)
+			length = PAGE_CACHE_PAGE_SIZE;
+		while (slot->length < length) {
+			received = pread(fd, &slot->data[slot->length], length - slot->length,
+					 (off_t)(address + slot->length));
+			if (received <= 0)
+				break;
+			slot->length += (unsigned long)received;
+		}
+		pthread_mutex_lock(&read_ahead_lock);
+		read_ahead_busy = FALSE;
+		pthread_cond_broadcast(&read_ahead_idle);
+		pthread_mutex_unlock(&read_ahead_lock);
+		/* A failed read ends the stream.  The consumer reads that page itself and
+		 * reports the error. */
+		if ((length == 0u) || (slot->length < length) || (address + length >= end))
+			done = TRUE;
+		slot->end_of_stream = done;
+		address += READ_AHEAD_STRIDE;
+		tail++;
+		sem_post(&read_ahead_filled);
+	}
+	return (void *)DPNULL;
+}
+
+/*
+ * Module: dp_read_ahead_seek
+ * 		purpose: Starts a new stream at the given address, starting the thread the first
+ *		time.  Slots of the previous stream are dropped by the consumer as it meets them.
+ * Return value:
+ * 		None.  Without the thread the page cache keeps reading synchronously.
+ */
+static void dp_read_ahead_seek(int fd, unsigned long address)
+{
+	pthread_t thread;
+
+	if (read_ahead_started == FALSE) {
+		if ((sem_init(&read_ahead_free, 0, READ_AHEAD_DEPTH) != 0) ||
+		    (sem_init(&read_ahead_filled, 0, 0u) != 0) ||
+		    (pthread_create(&thread, (pthread_attr_t *)DPNULL, dp_read_ahead_thread,
+				    DPNULL) != 0)) {
+			return;
+		}
+		pthread_detach(thread);
+		read_ahead_started = TRUE;
+	}
+
+	pthread_mutex_lock(&read_ahead_lock);
+	read_ahead_generation++;
+	read_ahead_fd = fd;
+	read_ahead_start = address;
+	read_ahead_end = image_size;
+	pthread_cond_signal(&read_ahead_wake);
+	pthread_mutex_unlock(&read_ahead_lock);
+
+	read_ahead_next = address;
+	read_ahead_active = TRUE;
+	return;
+}
+
+/*
+ * Module: dp_read_ahead_get
+ * 		purpose: Called by dp_get_page_data on a page cache miss.  Fills page from the ring
+ *		when the requested address is part of the current stream, waiting for the thread if
+ *		the page is still being read.  Pages of the stream that were skipped are released.
+ * Return value:
+ * 		TRUE if page was filled, FALSE if the page has to be read synchronously.
+ */
+unsigned char dp_read_ahead_get(unsigned long image_requested_address, struct dp_page *page)
+{
+	struct dp_read_ahead_slot *slot;
+	unsigned char status = FALSE;
+	unsigned char stalled = FALSE;
+	unsigned long length;
+	int filled;
+
+	/* Requests behind the stream or beyond what the ring can hold are not sequential */
+	if ((read_ahead_active == FALSE) || (image_requested_address < read_ahead_next) ||
+	    (image_requested_address >= read_ahead_next + READ_AHEAD_DEPTH * READ_AHEAD_STRIDE)) {
+		return FALSE;
+	}
+
+	while ((status == FALSE) && (read_ahead_active == TRUE)) {
+		sem_getvalue(&read_ahead_filled, &filled);
+		if (sem_trywait(&read_ahead_filled) != 0) {
+			stalled = TRUE;
+			while ((sem_wait(&read_ahead_filled) != 0) && (errno == EINTR)) {
+			}
+		}
+		slot = &read_ahead_ring[read_ahead_head % READ_AHEAD_DEPTH];
+		read_ahead_head++;
+
+		if (slot->generation == read_ahead_generation) {
+			length = slot->length;
+			if (slot->start_address + length > image_size)
+				length = (slot->start_address < image_size) ?
+					     image_size - slot->start_address : 0u;
+			if ((image_requested_address + MIN_VALID_BYTES_IN_PAGE <=
+			     slot->start_address + length) ||
+			    ((slot->start_address + length == image_size) &&
+			     (image_requested_address < image_size))) {
+				page->start_address = slot->start_address;
+				page->length = length;
+				memcpy(page->data, slot->data, length);
+				status = TRUE;
+				if ((unsigned long)filled < read_ahead_low_water)
+					read_ahead_low_water = (unsigned long)filled;
+			}
+			if (slot->end_of_stream == TRUE)
+				read_ahead_active = FALSE;
+			read_ahead_next = slot->start_address + READ_AHEAD_STRIDE;
+		}
+		sem_post(&read_ahead_free);
+	}
+
+	if (status == TRUE) {
+		if (stalled == TRUE)
+			read_ahead_stalls++;
+		else
+			read_ahead_hits++;
+	}
+	return status;
+}
+
+/*
+ * Module: dp_read_ahead_note_miss
+ * 		purpose: Called by dp_get_page_data after it read a page synchronously.  A page that
+ *		continues the previous one means the image is being walked, so the thread is asked
+ *		to stream the pages that follow it.
+ *
+ */
+void dp_read_ahead_note_miss(int fd, unsigned long image_requested_address, unsigned long length)
+{
+	read_ahead_sync_reads++;
+	if ((image_requested_address <= read_ahead_miss_end) &&
+	    (image_requested_address + MIN_VALID_BYTES_IN_PAGE > read_ahead_miss_end) &&
+	    (image_requested_address + length < image_size)) {
+		dp_read_ahead_seek(fd, image_requested_address + READ_AHEAD_STRIDE);
+	}
+	read_ahead_miss_end = image_requested_address + length;
+	return;
+}
+
+/*
+ * Module: dp_read_ahead_invalidate
+ * 		purpose: Stops the current stream.  Called when another image is selected or the
+ *		file of the streamed image is closed.  Returns once the thread is out of a read it
+ *		had already started, so the caller may close the file.  The thread takes the new,
+ *		empty stream before it reads again.
+ *
+ */
+void dp_read_ahead_invalidate(void)
+{
+	if (read_ahead_started == TRUE) {
+		pthread_mutex_lock(&read_ahead_lock);
+		read_ahead_generation++;
+		read_ahead_fd = -1;
+		read_ahead_start = 0u;
+		read_ahead_end = 0u;
+		pthread_cond_signal(&read_ahead_wake);
+		while (read_ahead_busy == TRUE)
+			pthread_cond_wait(&read_ahead_idle, &read_ahead_lock);
+		pthread_mutex_unlock(&read_ahead_lock);
+	}
+	read_ahead_active = FALSE;
+	read_ahead_miss_end = 0u;
+	return;
+}
+
+void dp_reset_read_ahead_stats(void)
+{
+	read_ahead_hits = 0u;
+	read_ahead_stalls = 0u;
+	read_ahead_sync_reads = 0u;
+	read_ahead_low_water = READ_AHEAD_DEPTH;
+	return;
+}
+
+void dp_display_read_ahead_stats(void)
+{
+#ifdef ENABLE_DISPLAY
+	dp_display_text("\r\nRead-ahead depth: ");
+	dp_display_value(READ_AHEAD_DEPTH, DEC);
+	dp_display_text(" low water: ");
+	dp_display_value(read_ahead_low_water, DEC);
+	dp_display_text(" ready: ");
+	dp_display_value(read_ahead_hits, DEC);
+	dp_display_text(" stalls: ");
+	dp_display_value(read_ahead_stalls, DEC);
+	dp_display_text(" synchronous reads: ");
+	dp_display_value(read_ahead_sync_reads, DEC);
+#endif
+	return;
+}
+#endif
+
+/*   *************** End of File *************** */
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpreadahead.h                                           */
+/*                                                                          */
+/*  Description:    Contains function prototypes of the read-ahead thread   */
+/*  that prefetches image pages for the USE_PAGING page cache               */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPREADAHEAD_H
+#define INC_DPREADAHEAD_H
+
+#include "dpcom.h"
+
+#if defined(USE_PAGING) && defined(USE_READ_AHEAD)
+/* Number of pages the thread keeps loaded ahead of the page cache.  Consecutive pages
+ * overlap by MIN_VALID_BYTES_IN_PAGE so that every request is served by a single page. */
+#define READ_AHEAD_DEPTH 8u
+
+extern unsigned long read_ahead_hits;
+extern unsigned long read_ahead_stalls;
+extern unsigned long read_ahead_sync_reads;
+extern unsigned long read_ahead_low_water;
+
+unsigned char dp_read_ahead_get(unsigned long image_requested_address, struct dp_page *page);
+void dp_read_ahead_note_miss(int fd, unsigned long image_requested_address, unsigned long length);
+void dp_read_ahead_invalidate(void);
+void dp_reset_read_ahead_stats(void);
+void dp_display_read_ahead_stats(void);
+#endif
+
+#endif /* INC_DPREADAHEAD_H */
+
+/*   *************** End of File *************** */
@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dptimer.c                                               */
+/*                                                                          */
+/*  Description:    Monotonic timing of actions and their phases, time      */
+/*  budgets and cooperative cancellation.  The poll loops and the frame     */
+/*  loop call dp_timer_expired so that a dead board is abandoned within a   */
+/*  bounded time instead of running out the iteration limits.              */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dptimer.h"
+#include "dpuser.h"
+#include "dpalg.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+unsigned long dp_action_time_budget = 0u;
+unsigned long dp_operation_time_budget = 0u;
+volatile sig_atomic_t dp_cancel_requested = 0;
+
+unsigned long timer_action_start;
+unsigned long long timer_action_start_ns;
+unsigned long timer_operation_start;
+unsigned char timer_abort_code = DPE_SUCCESS;
+
+struct dp_timer_phase timer_phases[DP_TIMER_MAX_PHASES];
+unsigned int timer_phase_count;
+unsigned long long timer_phase_start;
+/* Time of the phases measured before the action started, see dp_timer_add_phase */
+unsigned long long timer_added_ns;
+unsigned char timer_phase_open = FALSE;
+
+unsigned long dp_timer_ms(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long)now.tv_sec * 1000u + (unsigned long)now.tv_nsec / 1000000u;
+}
+
+unsigned long long dp_timer_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;
+}
+
+/*
+ * Module: dp_timer_start_action
+ * 		purpose: Starts the action budget and clears the phase table.  A cancellation
+ *		requested before the action started stays pending, the first dp_timer_expired
+ *		of the action reports it.
+ *
+ */
+void dp_timer_start_action(void)
+{
+	timer_action_start_ns = dp_timer_ns();
+	timer_action_start = (unsigned long)(timer_action_start_ns / 1000000ull);
+	timer_operation_start = timer_action_start;
+	timer_abort_code = DPE_SUCCESS;
+	timer_phase_count = 0u;
+	timer_phase_open = FALSE;
+	timer_added_ns = 0u;
+	return;
+}
+
+/* Milliseconds since dp_timer_start_action */
+unsigned long dp_timer_action_ms(void)
+{
+	return dp_timer_ms() - timer_action_start;
+}
+
+/* Nanoseconds since dp_timer_start_action, plus the phases added by dp_timer_add_phase */
+unsigned long long dp_timer_total_ns(void)
+{
+	return dp_timer_ns() - timer_action_start_ns + timer_added_ns;
+}
+
+void dp_timer_start_operation(void)
+{
+	if (dp_operation_time_budget != 0u)
+		timer_operation_start = dp_timer_ms();
+	return;
+}
+
+/*
+ * Module: dp_timer_expired
+ * 		purpose: Checks the cancellation flag and the time budgets.  The first time one
+ *		of them trips, error_code is set and the reason is displayed.  From then on
+ *		every call returns TRUE so that all the remaining loops of the action exit
+ *		after a single iteration.
+ * Return value:
+ * 		TRUE if the action must be abandoned.
+ *
+ */
+unsigned char dp_timer_expired(void)
+{
+	unsigned long now;
+
+	if (timer_abort_code != DPE_SUCCESS)
+		return TRUE;
+
+	if (dp_cancel_requested != 0) {
+		/* Consumed here, timer_abort_code holds it for the rest of the action */
+		dp_cancel_requested = 0;
+		timer_abort_code = DPE_ACTION_CANCELLED;
+#ifdef ENABLE_DISPLAY
+		dp_display_text("\r\nAction cancelled.");
+#endif
+	} else if ((dp_action_time_budget != 0u) || (dp_operation_time_budget != 0u)) {
+		now = dp_timer_ms();
+		if ((dp_action_time_budget != 0u) &&
+		    (now - timer_action_start >= dp_action_time_budget)) {
+			timer_abort_code = DPE_TIME_BUDGET_EXCEEDED;
+#ifdef ENABLE_DISPLAY
+			dp_display_text("\r\nAction time budget exceeded (ms): ");
+			dp_display_value(dp_action_time_budget, DEC);
+#endif
+		} else if ((dp_operation_time_budget != 0u) &&
+			   (now - timer_operation_start >= dp_operation_time_budget)) {
+			timer_abort_code = DPE_TIME_BUDGET_EXCEEDED;
+#ifdef ENABLE_DISPLAY
+			dp_display_text("\r\nOperation time budget exceeded (ms): ");
+			dp_display_value(dp_operation_time_budget, DEC);
+#endif
+		}
+	}
+
+	if (timer_abort_code != DPE_SUCCESS) {
+		error_code = timer_abort_code;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+unsigned char dp_timer_abort_code(void)
+{
+	return timer_abort_code;
+}
+
+void dp_timer_cancel(void)
+{
+	dp_cancel_requested = 1;
+	return;
+}
+
+/* SIGINT handler.  A second interrupt terminates the process. */
+void dp_timer_interrupt(int signal_number)
+{
+	dp_cancel_requested = 1;
+	signal(signal_number, SIG_DFL);
+}
+
+/*
+ * Module: dp_timer_begin_phase
+ * 		purpose: Closes the current phase and starts a new one.  number is appended to
+ *		the name when it is not 0, e.g. the component number.
+ *
+ */
+void dp_timer_begin_phase(signed char *name, unsigned int number)
+{
+	struct dp_timer_phase *phase;
+
+	dp_timer_end_phase();
+	if (timer_phase_count == DP_TIMER_MAX_PHASES)
+		return;
+
+	phase = &timer_phases[timer_phase_count];
+	if (number != 0u)
+		snprintf((char *)phase->name, DP_TIMER_PHASE_NAME_SIZE, "%s %u", name, number);
+	else
+		snprintf((char *)phase->name, DP_TIMER_PHASE_NAME_SIZE, "%s", name);
+	phase->elapsed_ns = 0u;
+	timer_phase_count++;
+	timer_phase_open = TRUE;
+	timer_phase_start = dp_timer_ns();
+	return;
+}
+
+void dp_timer_end_phase(void)
+{
+	if (timer_phase_open == TRUE) {
+		timer_phases[timer_phase_count - 1u].elapsed_ns = dp_timer_ns() - timer_phase_start;
+		timer_phase_open = FALSE;
+	}
+	return;
+}
+
+/*
+ * Module: dp_timer_add_phase
+ * 		purpose: Adds a phase that was measured before dp_timer_start_action, such as the
+ *		loading of the DAT file.  It is counted in the total of the table.  Called before
+ *		the first dp_timer_begin_phase of the action.
+ *
+ */
+void dp_timer_add_phase(signed char *name, unsigned long long elapsed_ns)
+{
+	if ((timer_phase_open == TRUE) || (timer_phase_count == DP_TIMER_MAX_PHASES))
+		return;
+	snprintf((char *)timer_phases[timer_phase_count].name, DP_TIMER_PHASE_NAME_SIZE, "%s",
+		 name);
+	timer_phases[timer_phase_count].elapsed_ns = elapsed_ns;
+	timer_phase_count++;
+	timer_added_ns += elapsed_ns;
+	return;
+}
+
+/*
+ * Module: dp_timer_display_phases
+ * 		purpose: Displays the time of each phase of the action as a table, in milliseconds
+ *		with microsecond resolution, with the share of the total.
+ *
+ */
+void dp_timer_display_phases(void)
+{
+#ifdef ENABLE_DISPLAY
+	signed char line[80];
+	unsigned long long total;
+	unsigned int index;
+
+	dp_timer_end_phase();
+	total = dp_timer_total_ns();
+	snprintf((char *)line, sizeof(line), "\r\n%-24s %15s %7s", "Phase", "Time (ms)", "%");
+	dp_display_text(line);
+	for (index = 0u; index < timer_phase_count; index++) {
+		snprintf((char *)line, sizeof(line), "\r\n%-24s %15.3f %7.1f", timer_phases[index].name,
+			 (double)timer_phases[index].elapsed_ns / 1e6,
+			 (total != 0u) ? (double)timer_phases[index].elapsed_ns * 100.0 / (double)total
+				       : 0.0);
+		dp_display_text(line);
+	}
+	snprintf((char *)line, sizeof(line), "\r\n%-24s %15.3f", "Total", (double)total / 1e6);
+	dp_display_text(line);
+#endif
+	return;
+}
+
+/*   *************** End of File *************** */
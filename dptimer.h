@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dptimer.h                                               */
+/*                                                                          */
+/*  Description:    Contains function prototypes of the monotonic timer,    */
+/*  the action and operation time budgets and cooperative cancellation      */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_DPTIMER_H
+#define INC_DPTIMER_H
+
+#include <signal.h>
+
+#define DP_TIMER_MAX_PHASES	64u
+#define DP_TIMER_PHASE_NAME_SIZE 24u
+
+struct dp_timer_phase {
+	signed char name[DP_TIMER_PHASE_NAME_SIZE];
+	unsigned long long elapsed_ns;
+};
+
+/* Time budgets in milliseconds.  0 disables the budget. */
+extern unsigned long dp_action_time_budget;
+extern unsigned long dp_operation_time_budget;
+/* Set asynchronously (signal handler or another thread) to abandon the action, or the
+ * next one when no action is running.  Cleared once dp_timer_expired reports it. */
+extern volatile sig_atomic_t dp_cancel_requested;
+/* Phases of the current action, see dp_timer_begin_phase */
+extern struct dp_timer_phase timer_phases[DP_TIMER_MAX_PHASES];
+extern unsigned int timer_phase_count;
+
+unsigned long dp_timer_ms(void);
+unsigned long long dp_timer_ns(void);
+void dp_timer_start_action(void);
+unsigned long dp_timer_action_ms(void);
+unsigned long long dp_timer_total_ns(void);
+void dp_timer_start_operation(void);
+unsigned char dp_timer_expired(void);
+unsigned char dp_timer_abort_code(void);
+void dp_timer_cancel(void);
+void dp_timer_interrupt(int signal_number);
+void dp_timer_begin_phase(signed char *name, unsigned int number);
+void dp_timer_end_phase(void);
+void dp_timer_add_phase(signed char *name, unsigned long long elapsed_ns);
+void dp_timer_display_phases(void);
+
+#endif /* INC_DPTIMER_H */
+
+/*   *************** End of File *************** */
@@ -15,19 +15,26 @@
 #include "dpSPIalg.h"
 #include "dpalg.h"
 #include "dpcom.h"
+#include "dpmetrics.h"
 
-#include <ctype.h>
 #include <gpiod.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/stat.h>
+#include <sys/prctl.h>
+#include <time.h>
 #include <unistd.h>
 
 /* This variable is used to select external programming */
 unsigned char hardware_interface = GPIO_SEL;
 unsigned char enable_mss_support = FALSE;
 
+#ifdef ENABLE_DISPLAY
+/* When set, display text and progress go to these functions instead of stdout */
+void (*dp_display_hook)(signed char *text) = DPNULL;
+void (*dp_progress_hook)(unsigned char value) = DPNULL;
+#endif
+
 #ifdef ENABLE_EMBEDDED_SUPPORT
 /*
  * Module: dp_jtag_init
@@ -41,6 +48,7 @@ void dp_jtag_init(struct gpio_handle *jtag_gpio)
 {
 	gpiod_line_set_value(jtag_gpio->tck, 1);
 	gpiod_line_set_value(jtag_gpio->trst, 1);
+	DP_METRICS_ADD(gpio_writes, 2u);
 	return;
 }
 
@@ -59,6 +67,8 @@ void dp_jtag_tms(struct gpio_handle *jtag_gpio, unsigned char tms)
 	gpiod_line_set_value(jtag_gpio->tms, tms);
 	gpiod_line_set_value(jtag_gpio->tck, 0);
 	gpiod_line_set_value(jtag_gpio->tck, 1);
+	DP_METRICS_ADD(gpio_writes, 3u);
+	DP_METRICS_ADD(tck_cycles, 1u);
 	return;
 }
 
@@ -80,6 +90,8 @@ void dp_jtag_tms_tdi(struct gpio_handle *jtag_gpio, unsigned char tms, unsigned
 	gpiod_line_set_value(jtag_gpio->tck, 0);
 
 	gpiod_line_set_value(jtag_gpio->tck, 1);
+	DP_METRICS_ADD(gpio_writes, 4u);
+	DP_METRICS_ADD(tck_cycles, 1u);
 
 	return;
 }
@@ -109,6 +121,9 @@ unsigned char dp_jtag_tms_tdi_tdo(struct gpio_handle *jtag_gpio, unsigned char t
 	if (gpiod_line_get_value(jtag_gpio->tdo))
 		ret = 0x80;
 	gpiod_line_set_value(jtag_gpio->tck, 1);
+	DP_METRICS_ADD(gpio_writes, 4u);
+	DP_METRICS_ADD(gpio_reads, 1u);
+	DP_METRICS_ADD(tck_cycles, 1u);
 
 	return ret;
 }
@@ -116,7 +131,12 @@ unsigned char dp_jtag_tms_tdi_tdo(struct gpio_handle *jtag_gpio, unsigned char t
 /*
  * User attention:
  * Module: dp_delay
- * 		purpose: Execute a time delay for a specified amount of time.
+ * 		purpose: Execute a time delay for a specified amount of time.  Delays up to
+ * 				 DP_DELAY_SPIN_LIMIT are busy-waited on CLOCK_MONOTONIC: usleep(10) sleeps
+ * 				 60 us or more because of timer slack and scheduling, longer than the JTAG
+ * 				 time of a frame.  Longer delays sleep until their deadline with the timer
+ * 				 slack of the thread lowered to 1 ns.  A signal ends the sleep early, as it
+ * 				 did with usleep.
  * Arguments:
  * 		microseconeds: 32 bit value containing the amount of wait time in microseconds.
  * Return value: None
@@ -124,13 +144,40 @@ unsigned char dp_jtag_tms_tdi_tdo(struct gpio_handle *jtag_gpio, unsigned char t
  */
 void dp_delay(unsigned long microseconds)
 {
-	usleep(microseconds);
+	static __thread unsigned char timer_slack_set = FALSE;
+	struct timespec deadline;
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += (time_t)(microseconds / 1000000u);
+	deadline.tv_nsec += (long)(microseconds % 1000000u) * 1000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	if (microseconds <= DP_DELAY_SPIN_LIMIT) {
+		do {
+			clock_gettime(CLOCK_MONOTONIC, &now);
+		} while ((now.tv_sec < deadline.tv_sec) ||
+			 ((now.tv_sec == deadline.tv_sec) && (now.tv_nsec < deadline.tv_nsec)));
+		return;
+	}
+	/* The slack is kept per thread, so every thread that drives the JTAG lines lowers its own */
+	if (timer_slack_set == FALSE) {
+		prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+		timer_slack_set = TRUE;
+	}
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, (struct timespec *)DPNULL);
 	return;
 }
 
 #ifdef ENABLE_DISPLAY
 void dp_report_progress(unsigned char value)
 {
+	if (dp_progress_hook != DPNULL) {
+		dp_progress_hook(value);
+		return;
+	}
 	if (old_progress == 0)
 		dp_display_text("\n");
 	dp_display_text("\rProgress: ");
@@ -142,6 +189,10 @@ void dp_report_progress(unsigned char value)
 
 void dp_display_text(signed char *text)
 {
+	if (dp_display_hook != DPNULL) {
+		dp_display_hook(text);
+		return;
+	}
 	printf("%s", text);
 	fflush(stdout);
 	return;
@@ -149,55 +200,62 @@ void dp_display_text(signed char *text)
 
 void dp_display_value(unsigned long value, unsigned int descriptive)
 {
+	signed char text[24];
+
+	text[0] = 0;
 	if (descriptive == HEX) {
-		printf("%lX", value);
+		snprintf((char *)text, sizeof(text), "%lX", value);
 	} else if (descriptive == DEC) {
-		printf("%2ld", value);
+		snprintf((char *)text, sizeof(text), "%2ld", value);
 	} else if (descriptive == CHR) {
-		printf("%c", (unsigned char)value);
+		snprintf((char *)text, sizeof(text), "%c", (unsigned char)value);
 	} else {
 	}
-	fflush(stdout);
+	dp_display_text(text);
 
 	return;
 }
 
 void dp_display_array(unsigned char *outbuf, unsigned int bytes, unsigned int descriptive)
 {
+	signed char text[8];
 	unsigned int i;
 	for (i = 0u; i < bytes; i++) {
+		text[0] = 0;
 		if ((i != 0) && (i % 16) == 0) {
-			printf("\r\n");
+			dp_display_text("\r\n");
 		}
 		if (descriptive == HEX) {
-			printf("%2lX ", outbuf[bytes - i - 1]);
+			snprintf((char *)text, sizeof(text), "%2X ", outbuf[bytes - i - 1]);
 		} else if (descriptive == DEC) {
-			printf("%ld ", outbuf[bytes - i - 1]);
+			snprintf((char *)text, sizeof(text), "%d ", outbuf[bytes - i - 1]);
 		} else if (descriptive == CHR) {
-			printf("%c ", (unsigned char)outbuf[bytes - i - 1]);
+			snprintf((char *)text, sizeof(text), "%c ", (unsigned char)outbuf[bytes - i - 1]);
 		} else {
 		}
+		dp_display_text(text);
 	}
-	fflush(stdout);
 	return;
 }
 void dp_display_array_reverse(unsigned char *outbuf, unsigned int bytes, unsigned int descriptive)
 {
+	signed char text[8];
 	unsigned int i;
 	for (i = 0u; i < bytes; i++) {
+		text[0] = 0;
 		if ((i != 0) && (i % 16) == 0) {
-			printf("\r\n");
+			dp_display_text("\r\n");
 		}
 		if (descriptive == HEX) {
-			printf("%2lX ", outbuf[i]);
+			snprintf((char *)text, sizeof(text), "%2X ", outbuf[i]);
 		} else if (descriptive == DEC) {
-			printf("%ld ", outbuf[i]);
+			snprintf((char *)text, sizeof(text), "%d ", outbuf[i]);
 		} else if (descriptive == CHR) {
-			printf("%c ", (unsigned char)outbuf[i]);
+			snprintf((char *)text, sizeof(text), "%c ", (unsigned char)outbuf[i]);
 		} else {
 		}
+		dp_display_text(text);
 	}
-	fflush(stdout);
 	return;
 }
 
@@ -245,18 +303,69 @@ unsigned char dp_get_Action_code(signed char *pAction)
 		Action_code_value = DP_SPI_FLASH_VERIFY_ACTION_CODE;
 	} else if (strcasecmp(pAction, DP_SPI_FLASH_BLANK_CHECK) == 0) {
 		Action_code_value = DP_SPI_FLASH_BLANK_CHECK_ACTION_CODE;
+	} else if (strcasecmp(pAction, DP_DAT_INFO) == 0) {
+		Action_code_value = DP_DAT_INFO_ACTION_CODE;
+	} else if (strcasecmp(pAction, DP_PROGRAM_IF_DIFFERENT) == 0) {
+		Action_code_value = DP_PROGRAM_IF_DIFFERENT_ACTION_CODE;
 	} else {
 		Action_code_value = DP_NO_ACTION_FOUND;
 	}
 	return Action_code_value;
 }
 
+/* Name of an action code, the reverse of dp_get_Action_code */
+signed char *dp_get_Action_name(unsigned char Action_code_value)
+{
+	switch (Action_code_value) {
+	case DP_DEVICE_INFO_ACTION_CODE:
+		return (signed char *)DP_DEVICE_INFO_ACTION;
+	case DP_READ_IDCODE_ACTION_CODE:
+		return (signed char *)DP_READ_IDCODE_ACTION;
+	case DP_ERASE_ACTION_CODE:
+		return (signed char *)DP_ERASE_ACTION;
+	case DP_PROGRAM_ACTION_CODE:
+		return (signed char *)DP_PROGRAM_ACTION;
+	case DP_VERIFY_ACTION_CODE:
+		return (signed char *)DP_VERIFY_ACTION;
+	case DP_ENC_DATA_AUTHENTICATION_ACTION_CODE:
+		return (signed char *)DP_ENC_DATA_AUTHENTICATION_ACTION;
+	case DP_VERIFY_DIGEST_ACTION_CODE:
+		return (signed char *)DP_VERIFY_DIGEST;
+	case DP_VALIDATE_USER_ENC_KEYS_ACTION_CODE:
+		return (signed char *)DP_VALIDATE_USER_ENC_KEYS;
+	case DP_READ_DEVICE_CERTIFICATE_ACTION_CODE:
+		return (signed char *)DP_READ_DEVICE_CERTIFICATE;
+	case DP_ZEROIZE_LIKE_NEW_ACTION_CODE:
+		return (signed char *)DP_ZEROIZE_LIKE_NEW;
+	case DP_ZEROIZE_UNRECOVERABLE_ACTION_CODE:
+		return (signed char *)DP_ZEROIZE_UNRECOVERABLE;
+	case DP_SPI_FLASH_READ_ID_ACTION_CODE:
+		return (signed char *)DP_SPI_FLASH_READ_ID;
+	case DP_SPI_FLASH_READ_ACTION_CODE:
+		return (signed char *)DP_SPI_FLASH_READ;
+	case DP_SPI_FLASH_ERASE_ACTION_CODE:
+		return (signed char *)DP_SPI_FLASH_ERASE;
+	case DP_SPI_FLASH_PROGRAM_ACTION_CODE:
+		return (signed char *)DP_SPI_FLASH_PROGRAM;
+	case DP_SPI_FLASH_VERIFY_ACTION_CODE:
+		return (signed char *)DP_SPI_FLASH_VERIFY;
+	case DP_SPI_FLASH_BLANK_CHECK_ACTION_CODE:
+		return (signed char *)DP_SPI_FLASH_BLANK_CHECK;
+	case DP_DAT_INFO_ACTION_CODE:
+		return (signed char *)DP_DAT_INFO;
+	case DP_PROGRAM_IF_DIFFERENT_ACTION_CODE:
+		return (signed char *)DP_PROGRAM_IF_DIFFERENT;
+	}
+	return (signed char *)"unknown";
+}
+
 int gpio_config(struct gpio_handle *jtag_gpio)
 {
 	char compatible[100];
-	char *gpiochip;
+	char *gpiochip = DPNULL;
 	unsigned int TCK_PIN, TDI_PIN, TMS_PIN, TRST_PIN, TDO_PIN;
 
+	memset(jtag_gpio, 0, sizeof(struct gpio_handle));
 	FILE *file = fopen("/proc/device-tree/compatible", "r");
 	if(file != NULL && fscanf(file, "%s", compatible)) {
 
@@ -282,187 +391,58 @@ int gpio_config(struct gpio_handle *jtag_gpio)
 		fclose(file);
 	}
 
-	char *chipname = gpiochip;
-	struct gpiod_chip *chip;
-	chip = gpiod_chip_open(chipname);
+	if (gpiochip != DPNULL)
+		jtag_gpio->chip = gpiod_chip_open(gpiochip);
+	if (!jtag_gpio->chip) {
+		printf("Error: Failed to initialize GPIO module.\n");
+		return -1;
+	}
 	/* open the GPIO line */
-	jtag_gpio->tck = gpiod_chip_get_line(chip, TCK_PIN);
-	jtag_gpio->tdi = gpiod_chip_get_line(chip, TDI_PIN);
-	jtag_gpio->tms = gpiod_chip_get_line(chip, TMS_PIN);
-	jtag_gpio->trst = gpiod_chip_get_line(chip, TRST_PIN);
-	jtag_gpio->tdo = gpiod_chip_get_line(chip, TDO_PIN);
+	jtag_gpio->tck = gpiod_chip_get_line(jtag_gpio->chip, TCK_PIN);
+	jtag_gpio->tdi = gpiod_chip_get_line(jtag_gpio->chip, TDI_PIN);
+	jtag_gpio->tms = gpiod_chip_get_line(jtag_gpio->chip, TMS_PIN);
+	jtag_gpio->trst = gpiod_chip_get_line(jtag_gpio->chip, TRST_PIN);
+	jtag_gpio->tdo = gpiod_chip_get_line(jtag_gpio->chip, TDO_PIN);
 
 	/* set the direction of GPIO */
-	gpiod_line_request_output(jtag_gpio->tck, "gpio-tck", GPIOD_LINE_ACTIVE_STATE_HIGH);
-	gpiod_line_request_output(jtag_gpio->tdi, "gpio-tdi", GPIOD_LINE_ACTIVE_STATE_HIGH);
-	gpiod_line_request_output(jtag_gpio->tms, "gpio-tms", GPIOD_LINE_ACTIVE_STATE_HIGH);
-	gpiod_line_request_output(jtag_gpio->trst, "gpio-trst", GPIOD_LINE_ACTIVE_STATE_HIGH);
-	gpiod_line_request_input(jtag_gpio->tdo, "gpio-tdo");
-
-	if (!chip) {
-		printf("Error: Failed to initialize GPIO module.\n");
+	if ((!jtag_gpio->tck) || (!jtag_gpio->tdi) || (!jtag_gpio->tms) ||
+	    (!jtag_gpio->trst) || (!jtag_gpio->tdo) ||
+	    (gpiod_line_request_output(jtag_gpio->tck, "gpio-tck", GPIOD_LINE_ACTIVE_STATE_HIGH) != 0) ||
+	    (gpiod_line_request_output(jtag_gpio->tdi, "gpio-tdi", GPIOD_LINE_ACTIVE_STATE_HIGH) != 0) ||
+	    (gpiod_line_request_output(jtag_gpio->tms, "gpio-tms", GPIOD_LINE_ACTIVE_STATE_HIGH) != 0) ||
+	    (gpiod_line_request_output(jtag_gpio->trst, "gpio-trst", GPIOD_LINE_ACTIVE_STATE_HIGH) != 0) ||
+	    (gpiod_line_request_input(jtag_gpio->tdo, "gpio-tdo") != 0)) {
+		printf("Error: Failed to claim the JTAG GPIO lines.\n");
+		gpio_release(jtag_gpio);
 		return -1;
 	}
+	return 0;
 }
 
-void displayActions()
-{
-	printf("Usage: directc_programmer [-h] [-a<action>] [filename]\n");
-	printf("-a<action>, Performs required action\n");
-	printf("Available actions:\n");
-	printf("\tprogram                 - Performs erase, program, and verify operations for supported blocks in data file\n");
-	printf("\terase                   - Erases supported blocks in data file\n");
-	printf("\tread_idcode             - Reads and displays the content of the IDCODE register\n");
-	printf("\tverify                  - Performs verify operation for supported blocks in data file\n");
-	printf("\tdevice_info             - Displays device design information and status, including security settings\n");
-	printf("\tenc_data_authentication - Performs data authentication for array to make sure data was encrypted with same encryption key as the device\n");
-	printf("\tverify_digest           - PolarFire specific action\n");
-	printf("\tvalidate_user_enc_keys  - Validates user encryption keys\n");
-	printf("\tread_device_certificate - Reads and displays device certificate\n");
-	printf("\tzeroize_like_new        - Performs zeroization. Device is recoverable\n");
-	printf("\tzeroize_unrecoverable   - Performs zeroization. Device is not recoverable\n");
-	printf("\tspi_flash_read_idcode   - Returns 3 bytes ID data as a response to RDID (9Fh) instruction\n");
-	printf("\tspi_flash_read          - Reads entire content of the SPI-Flash memory device. This operation could be extremely slow depending on how the read data is transmitted to host\n");
-	printf("\tspi_flash_erase         - Erases entire content of the SPI-Flash memory device\n");
-	printf("\tspi_flash_program       - Determines sectors needed to store the loaded image and then performs erasing of sectors followed by programming the image\n");
-	printf("\tspi_flash_verify        - Verifies device content against loaded image. Only memory region occupied by loaded image is verified\n");
-	printf("\tspi_flash_blank_check   - Verifies entire memory space of device is 0xFFh. This action can be very slow but is useful for debugging purposes\n\n");
-	printf("-h, Print this message\n\n");
-
-	printf("This program is built for arm-linux-gnueabihf-gcc \n");
-}
-
-int main(int argc, char **argv)
+/*
+ * Module: gpio_release
+ * 		purpose: Releases the lines claimed by gpio_config and closes the GPIO chip so
+ *		that a later gpio_config can claim them again.
+ * Return value: None
+ *
+ */
+void gpio_release(struct gpio_handle *jtag_gpio)
 {
-	signed int iExitStatus = 0;
-	signed int iArg;
-	signed char *pAction = (signed char *)DPNULL;
-	signed char *pFileName = (signed char *)DPNULL;
-	unsigned char bDATFileExists = FALSE;
-	struct stat sglobal_buf1;
-	unsigned long ulFileLength = 0L;
-	unsigned char *pFile_buffer = (unsigned char *)DPNULL;
-	FILE *fp = (FILE *)DPNULL;
-	signed int iExecResult = DPE_SUCCESS;
-	time_t start_time;
-	time_t end_time;
-	signed int iTimeDelta;
-	struct gpio_handle *jtag_gpio = malloc(sizeof(struct gpio_handle));
-	
-	for (iArg = 1; iArg < argc; iArg++) {
-		if ((argv[iArg][0] == '-')) {
-			switch (toupper(argv[iArg][1])) {
-				case 'A': /* set action name */
-					pAction = &argv[iArg][2];
-					if (argc < 3) {
-#ifdef ENABLE_DISPLAY
-						dp_display_text("-a<action> : specify action name\r\n\n");
-						displayActions();
-#endif
-					return -1;
-					}
-					break;
-				case 'H':
-					displayActions();
-					return 0;
-					break;
-				default:
-					printf("Invalid option\n");
-			}
-		} else {
-			/* it's a filename */
-			pFileName = argv[iArg];
-		}
-	} 
-
-	if ((pFileName != (signed char *)DPNULL)) {
-		bDATFileExists = TRUE;
-		/* get length of file */
-		if (stat(pFileName, &sglobal_buf1) == 0)
-			ulFileLength = sglobal_buf1.st_size;
-
-		if ((fp = fopen(pFileName, "rb")) == (FILE *)DPNULL) {
-#ifdef ENABLE_DISPLAY
-			dp_display_text("\r\nError: can't open file \n");
-			dp_display_text(pFileName);
-#endif
-			iExitStatus = 103;
-			} else {
-			/*
-			 *    Read entire file into a global_buf1fer
-			 */
-			pFile_buffer = (unsigned char *)dp_malloc(ulFileLength);
-			if (pFile_buffer == (unsigned char *)DPNULL) {
-#ifdef ENABLE_DISPLAY
-				dp_display_text("\r\nError: can't allocate memory (");
-				dp_display_value(ulFileLength / 1024, DEC);
-				dp_display_text(" Kbytes)\n");
-#endif
-				iExitStatus = 104;
-			} else {
-				if (fread(pFile_buffer, 1, (size_t)ulFileLength, fp) !=
-				    (size_t)ulFileLength) {
-#ifdef ENABLE_DISPLAY
-					dp_display_text("\r\nError reading file \n");
-					dp_display_text(pFileName);
-#endif
-					iExitStatus = 105;
-				} else
-					image_size = ulFileLength;
-			}
-
-			fclose(fp);
-		}
-	}
-	if (iExitStatus == 0) {
-
-		/*
-		 *    Execute the directc program
-		 */
-		image_buffer = pFile_buffer;
-		Action_code = dp_get_Action_code(pAction);
-		if (bDATFileExists == FALSE) {
-			time(&start_time);
-			dp_display_text("\r\nError: Dat file is required...\n");
-			iExecResult = 106;
-			time(&end_time);
-		} else {
-			gpio_config(jtag_gpio);
-			time(&start_time);
-			iExecResult = dp_top(jtag_gpio);
-			time(&end_time);
-		}
-
-		if (iExecResult != DPE_SUCCESS) {
-#ifdef ENABLE_DISPLAY
-			dp_display_text("\r\nError return code ");
-			dp_display_value(iExecResult, DEC);
-#endif
-		} else {
-#ifdef ENABLE_DISPLAY
-			dp_display_text("\r\nExit code = 0... Success\n");
-#endif
-		}
-
-		/*
-		 *    Print out elapsed time
-		 */
-		iTimeDelta = (int)(end_time - start_time);
-#ifdef ENABLE_DISPLAY
-		printf("\r\nElapsed time = %02u:%02u:%02u", iTimeDelta / 3600, /* hours */
-			 (iTimeDelta % 3600) / 60,				 /* minutes */
-			 iTimeDelta % 60);					 /* seconds */
-#endif
-		/*
-		 *    Print out elapsed time
-		 */
-
-		printf(" Done.\n");
-}
-
-	if (pFile_buffer != (unsigned char *)DPNULL)
-		dp_free(pFile_buffer);
-	return (iExitStatus);
+	if (!jtag_gpio->chip)
+		return;
+	if (jtag_gpio->tck)
+		gpiod_line_release(jtag_gpio->tck);
+	if (jtag_gpio->tdi)
+		gpiod_line_release(jtag_gpio->tdi);
+	if (jtag_gpio->tms)
+		gpiod_line_release(jtag_gpio->tms);
+	if (jtag_gpio->trst)
+		gpiod_line_release(jtag_gpio->trst);
+	if (jtag_gpio->tdo)
+		gpiod_line_release(jtag_gpio->tdo);
+	gpiod_chip_close(jtag_gpio->chip);
+	memset(jtag_gpio, 0, sizeof(struct gpio_handle));
+	return;
 }
 
 /* *************** End of File *************** */
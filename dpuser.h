@@ -20,10 +20,31 @@
 #define ENABLE_DISPLAY
 #define ENABLE_GPIO_SUPPORT
 #define PERFORM_CRC_CHECK
+/* Checks the image CRC in a thread while the device is identified.  Requires PERFORM_CRC_CHECK. */
+#define ENABLE_BACKGROUND_CRC
 #define ENABLE_SPI_FLASH_SUPPORT
 #define ENABLE_G5_SUPPORT
+#define ENABLE_DAEMON_SUPPORT
+#define ENABLE_BATCH_SUPPORT
+#define ENABLE_LOOP_SUPPORT
+/* Load gzip compressed DAT files (links with -lz) */
+#define ENABLE_GZIP_SUPPORT
+/* Load zstd compressed DAT files (add -lzstd to LDLIBS in the Makefile) */
+/* #define ENABLE_ZSTD_SUPPORT */
+/* Remembers a passed CRC check in <dat file>.dpcache so that later runs skip it */
+#define ENABLE_IMAGE_CACHE
+/* Computes the image CRC with PCLMULQDQ on x86 processors that have it */
+#define ENABLE_CRC_CLMUL
+/* Records every PolarFire action in a local history, see dphistory.h */
+#define ENABLE_HISTORY
+/* Displays the time of each phase after every action, not only a cancelled one */
+#define ENABLE_PHASE_TIMES
+/* Counts the JTAG traffic of each action for --metrics, see dpmetrics.h */
+#define ENABLE_METRICS
 
 //#define USE_PAGING
+/* Prefetches the pages of USE_PAGING in a thread.  Requires USE_PAGING. */
+//#define USE_READ_AHEAD
 /* #define CHAIN_SUPPORT */
 /* Enable BSR_SAMPLE switch maintains the last known state of the IOs regardless
  *  of the data file setting. */
@@ -32,6 +53,7 @@
 /*************** End of compiler switches ***********************************/
 struct gpio_handle {
 	/*Hardware related constants*/
+	struct gpiod_chip *chip;
 	struct gpiod_line *tck;
 	struct gpiod_line *tdi;
 	struct gpiod_line *tms;
@@ -49,6 +71,9 @@ extern unsigned char *image_buffer;
 extern unsigned char hardware_interface;
 extern unsigned char enable_mss_support;
 
+/* dp_delay busy-waits for delays up to this many microseconds and sleeps for longer ones */
+#define DP_DELAY_SPIN_LIMIT 100u
+
 void dp_exit_avionics_mode(void);
 void dp_delay(unsigned long microseconds);
 
@@ -61,11 +86,12 @@ void dp_jtag_tms_tdi(struct gpio_handle *jtag_gpio, unsigned char tms, unsigned
 unsigned char dp_jtag_tms_tdi_tdo(struct gpio_handle *jtag_gpio, unsigned char tms, unsigned char tdi);
 #endif
 
-#ifdef ENABLE_DISPLAY
 #define HEX 0u
 #define DEC 1u
 #define CHR 2u
 
+#ifdef ENABLE_DISPLAY
+
 /******************************************************************************/
 /* users should define their own functions to replace the following functions */
 /******************************************************************************/
@@ -76,11 +102,17 @@ void dp_display_array_reverse(unsigned char *outbuf, unsigned int bytes, unsigne
 void dp_report_progress(unsigned char value);
 #define PRINT_DELAY 250
 
+extern void (*dp_display_hook)(signed char *text);
+extern void (*dp_progress_hook)(unsigned char value);
+
 #endif
 
 void *dp_malloc(unsigned long size);
 void dp_free(void *ptr);
 unsigned char dp_get_Action_code(signed char *pAction);
+signed char *dp_get_Action_name(unsigned char Action_code_value);
+int gpio_config(struct gpio_handle *jtag_gpio);
+void gpio_release(struct gpio_handle *jtag_gpio);
 /***********************************************
 **	The following string action definitions could be ignored
 **	The user can call dp_top with the corresponding action code defined in dpalg.h
@@ -102,6 +134,8 @@ unsigned char dp_get_Action_code(signed char *pAction);
 #define DP_SPI_FLASH_PROGRAM		  "spi_flash_program"
 #define DP_SPI_FLASH_VERIFY		  "spi_flash_verify"
 #define DP_SPI_FLASH_BLANK_CHECK	  "spi_flash_blank_check"
+#define DP_DAT_INFO			  "dat_info"
+#define DP_PROGRAM_IF_DIFFERENT		  "program_if_different"
 
 #endif /* INC_DPUSER_H */
 
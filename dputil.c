@@ -14,6 +14,17 @@
 #include "dputil.h"
 #include "dpalg.h"
 #include "dpcom.h"
+#include "dpimage.h"
+#include "dpimagecheck.h"
+#include "dptimer.h"
+
+#include <pthread.h>
+#if defined(ENABLE_CRC_CLMUL) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DP_CRC16_CLMUL
+#endif
+#ifdef DP_CRC16_CLMUL
+#include <immintrin.h>
+#endif
 
 /*
  * General purpose Global variables needed in the program
@@ -28,6 +39,7 @@ unsigned int global_uint2;
 needed as long as it does not exceed 255 */
 unsigned char global_buf1[global_buf_SIZE]; /* General purpose global_buf1fer */
 unsigned char global_buf2[global_buf_SIZE]; /* global_buffer to hold UROW data */
+unsigned char image_crc_checked = FALSE;
 
 void dp_flush_global_buf1(void)
 {
@@ -53,6 +65,49 @@ void dp_init_vars(void)
 	return;
 }
 
+#ifdef PERFORM_CRC_CHECK
+/*
+ * Module: dp_compute_image_crc
+ * 		purpose: Computes the CRC of the image, except for the CRC stored in its last two
+ *		bytes, into global_uint1 and reports the progress.
+ * Return value:
+ * 		None
+ *
+ */
+static void dp_compute_image_crc(void)
+{
+#ifdef ENABLE_DISPLAY
+	dp_display_text("\r\nCalculating actual CRC.  Please wait...\r\n");
+#endif
+	/* Global_uint is used to hold the value of the calculated CRC */
+	global_uint1 = 0u;
+/* DataIndex is used to keep track the byte position in the image that is needed per
+ * get_data_request */
+#ifdef ENABLE_DISPLAY
+	old_progress = 0;
+#endif
+	DataIndex = 0u;
+	requested_bytes = image_size - 2u;
+	while (requested_bytes) {
+		page_buffer_ptr = dp_get_data(Header_ID, DataIndex * 8u);
+		if (return_bytes > requested_bytes)
+			return_bytes = requested_bytes;
+		global_uint1 = dp_crc16_update(global_uint1, page_buffer_ptr, return_bytes);
+		DataIndex += return_bytes;
+		requested_bytes -= return_bytes;
+
+#ifdef ENABLE_DISPLAY
+		new_progress = (DataIndex * 100 / (image_size - 2u));
+		if (new_progress != old_progress) {
+			dp_report_progress(new_progress);
+			old_progress = new_progress;
+		}
+#endif
+	}
+	return;
+}
+#endif
+
 /*
  * Module: dp_check_image_crc
  * 		purpose: Performs crc on the entire image.
@@ -65,6 +120,7 @@ void dp_check_image_crc(void)
 {
 #ifdef PERFORM_CRC_CHECK
 	unsigned int expected_crc;
+	unsigned long check_ms;
 #endif
 #ifdef PERFORM_CRC_CHECK
 #ifdef ENABLE_DISPLAY
@@ -90,40 +146,30 @@ void dp_check_image_crc(void)
 #ifdef ENABLE_DISPLAY
 			dp_display_text("\r\nData file is not loaded... \r\n");
 #endif
-		} else {
-#ifdef PERFORM_CRC_CHECK
+		} else if (image_crc_checked == TRUE) {
 #ifdef ENABLE_DISPLAY
-			dp_display_text("\r\nCalculating actual CRC.  Please wait...\r\n");
+			if ((selected_image != (struct dp_image *)DPNULL) &&
+			    (selected_image->crc_cached == TRUE)) {
+				dp_display_text("\r\nCRC check skipped, this file passed it before.  "
+						"Time saved (ms): ");
+				dp_display_value(selected_image->cache.check_ms, DEC);
+			} else {
+				dp_display_text("\r\nCRC was verified when the image was loaded.");
+			}
 #endif
+		} else {
+#ifdef PERFORM_CRC_CHECK
+			check_ms = dp_timer_ms();
+#ifdef ENABLE_BACKGROUND_CRC
 			/* Global_uint is used to hold the value of the calculated CRC */
-			global_uint1 = 0u;
-/* DataIndex is used to keep track the byte position in the image that is needed per
- * get_data_request */
-#ifdef ENABLE_DISPLAY
-			old_progress = 0;
-#endif
-			DataIndex = 0u;
-			requested_bytes = image_size - 2u;
-			while (requested_bytes) {
-				page_buffer_ptr = dp_get_data(Header_ID, DataIndex * 8u);
-				if (return_bytes > requested_bytes)
-					return_bytes = requested_bytes;
-				for (global_ulong1 = 0u; global_ulong1 < return_bytes;
-				     global_ulong1++) {
-					global_uchar1 = page_buffer_ptr[global_ulong1];
-					dp_compute_crc();
-				}
-				DataIndex += return_bytes;
-				requested_bytes -= return_bytes;
-
-#ifdef ENABLE_DISPLAY
-				new_progress = (DataIndex * 100 / (image_size - 2u));
-				if (new_progress != old_progress) {
-					dp_report_progress(new_progress);
-					old_progress = new_progress;
-				}
-#endif
+			if (dp_image_check_wait(selected_image, &global_uint1, &check_ms) == FALSE) {
+				dp_compute_image_crc();
+				check_ms = dp_timer_ms() - check_ms;
 			}
+#else
+			dp_compute_image_crc();
+			check_ms = dp_timer_ms() - check_ms;
+#endif
 
 			if (global_uint1 != expected_crc) {
 #ifdef ENABLE_DISPLAY
@@ -135,6 +181,9 @@ void dp_check_image_crc(void)
 				dp_display_text("\r\n");
 #endif
 				error_code = DPE_CRC_MISMATCH;
+			} else {
+				image_crc_checked = TRUE;
+				dp_image_crc_verified(check_ms);
 			}
 #else
 #ifdef ENABLE_DISPLAY
@@ -151,20 +200,301 @@ void dp_check_image_crc(void)
 	return;
 }
 
-void dp_compute_crc(void)
+/*
+ * CRC-16 engines.  The image CRC is the reflected CRC-16 with polynomial 0x8408, initial value 0
+ * and no final XOR.  dp_crc16_tables[0] is the classic byte table; dp_crc16_tables[n] advances
+ * a byte followed by n zero bytes, which lets the slicing-by-8 engine consume 8 bytes with 8
+ * independent lookups.  The tables and the engine choice are set up once, on first use.
+ */
+#define DP_CRC16_POLY	    0x8408u
+/* Size of the pattern that every engine is checked against before it is used */
+#define DP_CRC16_SELF_CHECK 1031u
+
+static unsigned short dp_crc16_tables[8][256];
+static pthread_once_t dp_crc16_once = PTHREAD_ONCE_INIT;
+static unsigned int (*dp_crc16_engine)(unsigned int crc, const unsigned char *data,
+				       unsigned long length);
+#ifdef DP_CRC16_CLMUL
+static unsigned char dp_crc16_clmul_supported = FALSE;
+#endif
+
+static unsigned int dp_crc16_bitwise(unsigned int crc, const unsigned char *data,
+				     unsigned long length)
 {
-	for (global_uchar2 = 0u; global_uchar2 < 8u; global_uchar2++) {
-		global_uint2 = (global_uchar1 ^ global_uint1) & 0x01u;
-		global_uint1 >>= 1u;
-		if (global_uint2) {
-			global_uint1 ^= 0x8408u;
+	unsigned long index;
+	unsigned char bit;
+	unsigned char byte;
+
+	for (index = 0u; index < length; index++) {
+		byte = data[index];
+		for (bit = 0u; bit < 8u; bit++) {
+			if ((byte ^ crc) & 0x01u) {
+				crc = (crc >> 1u) ^ DP_CRC16_POLY;
+			} else {
+				crc >>= 1u;
+			}
+			byte >>= 1u;
 		}
-		global_uchar1 >>= 1u;
 	}
+	return crc;
+}
+
+static unsigned int dp_crc16_table(unsigned int crc, const unsigned char *data,
+				   unsigned long length)
+{
+	while (length--)
+		crc = (crc >> 8u) ^ dp_crc16_tables[0][(crc ^ *data++) & 0xFFu];
+	return crc;
+}
+
+static unsigned int dp_crc16_slice8(unsigned int crc, const unsigned char *data,
+				    unsigned long length)
+{
+	while (length >= 8u) {
+		crc ^= (unsigned int)data[0] | ((unsigned int)data[1] << 8u);
+		crc = dp_crc16_tables[7][crc & 0xFFu] ^ dp_crc16_tables[6][crc >> 8u] ^
+		      dp_crc16_tables[5][data[2]] ^ dp_crc16_tables[4][data[3]] ^
+		      dp_crc16_tables[3][data[4]] ^ dp_crc16_tables[2][data[5]] ^
+		      dp_crc16_tables[1][data[6]] ^ dp_crc16_tables[0][data[7]];
+		data += 8u;
+		length -= 8u;
+	}
+	return dp_crc16_table(crc, data, length);
+}
+
+#ifdef DP_CRC16_CLMUL
+/*
+ * Carry-less multiply folding (x86 PCLMULQDQ).  The running remainder is kept as a 128 bit
+ * block.  Folding it forward over the next D bits multiplies its two 64 bit halves by
+ * x^(D+63) and x^(D-1) mod P (the -1 makes up for the product of two bit-reflected operands
+ * landing one bit low), and the product is XORed into the block found D bits later.  Four
+ * blocks are folded in parallel with D = 512, then merged with D = 128.  The last block and
+ * the tail are finished with the byte table, which yields the same remainder.
+ */
+static __m128i dp_crc16_fold_512;
+static __m128i dp_crc16_fold_128;
+
+/* x^n mod P in normal bit order (bit d is the coefficient of x^d) */
+static unsigned int dp_crc16_xpow(unsigned int n)
+{
+	unsigned int value = 1u;
+
+	while (n--) {
+		value <<= 1u;
+		if (value & 0x10000u)
+			value ^= 0x11021u;
+	}
+	return value;
+}
+
+/* Places the coefficient of x^d at bit 63 - d, the order of a reflected 64 bit lane */
+static unsigned long long dp_crc16_reflect64(unsigned int value)
+{
+	unsigned long long reflected = 0u;
+	unsigned int degree;
+
+	for (degree = 0u; degree < 16u; degree++) {
+		if (value & (1u << degree))
+			reflected |= 1ull << (63u - degree);
+	}
+	return reflected;
+}
+
+static __m128i dp_crc16_fold_constants(unsigned int distance)
+{
+	return _mm_set_epi64x((long long)dp_crc16_reflect64(dp_crc16_xpow(distance - 1u)),
+			      (long long)dp_crc16_reflect64(dp_crc16_xpow(distance + 63u)));
+}
+
+__attribute__((target("pclmul,sse2"))) static __m128i dp_crc16_fold(__m128i state,
+								     __m128i constants,
+								     __m128i next)
+{
+	return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(state, constants, 0x00),
+					   _mm_clmulepi64_si128(state, constants, 0x11)),
+			     next);
+}
+
+__attribute__((target("pclmul,sse2"))) static unsigned int
+dp_crc16_clmul(unsigned int crc, const unsigned char *data, unsigned long length)
+{
+	unsigned char block[16];
+	__m128i state[4];
+	unsigned char index;
+
+	if (length < 64u)
+		return dp_crc16_slice8(crc, data, length);
+
+	for (index = 0u; index < 4u; index++)
+		state[index] = _mm_loadu_si128((const __m128i *)(data + 16u * index));
+	/* Starting from crc is the same as XORing it into the first two bytes */
+	state[0] = _mm_xor_si128(state[0], _mm_cvtsi32_si128((int)crc));
+	data += 64u;
+	length -= 64u;
+
+	while (length >= 64u) {
+		for (index = 0u; index < 4u; index++)
+			state[index] = dp_crc16_fold(
+			    state[index], dp_crc16_fold_512,
+			    _mm_loadu_si128((const __m128i *)(data + 16u * index)));
+		data += 64u;
+		length -= 64u;
+	}
+	for (index = 1u; index < 4u; index++)
+		state[0] = dp_crc16_fold(state[0], dp_crc16_fold_128, state[index]);
+	while (length >= 16u) {
+		state[0] = dp_crc16_fold(state[0], dp_crc16_fold_128,
+					 _mm_loadu_si128((const __m128i *)data));
+		data += 16u;
+		length -= 16u;
+	}
+
+	_mm_storeu_si128((__m128i *)block, state[0]);
+	return dp_crc16_slice8(dp_crc16_slice8(0u, block, 16u), data, length);
+}
+#endif
+
+/*
+ * Module: dp_crc16_check_engine
+ * 		purpose: Cross-checks an engine against the bitwise reference over every length and
+ *		start offset of a fixed pattern, continuing from a non-zero CRC.
+ * Return value:
+ * 		TRUE if the engine agrees with the reference.
+ *
+ */
+static unsigned char dp_crc16_check_engine(unsigned int (*engine)(unsigned int crc,
+								   const unsigned char *data,
+								   unsigned long length))
+{
+	unsigned char pattern[DP_CRC16_SELF_CHECK];
+	unsigned long index;
+	unsigned long length;
+	unsigned int expected;
+
+	for (index = 0u; index < DP_CRC16_SELF_CHECK; index++)
+		pattern[index] = (unsigned char)((index * 167u + 13u) ^ (index >> 3u));
+	for (index = 0u; index < 8u; index++) {
+		expected = 0x1D0Fu;
+		for (length = 0u; length < 300u; length++) {
+			if (engine(0x1D0Fu, &pattern[index], length) != expected)
+				return FALSE;
+			expected = dp_crc16_bitwise(expected, &pattern[index + length], 1u);
+		}
+	}
+	return (engine(0u, pattern, DP_CRC16_SELF_CHECK) ==
+		dp_crc16_bitwise(0u, pattern, DP_CRC16_SELF_CHECK))
+		   ? TRUE
+		   : FALSE;
+}
+
+/*
+ * Module: dp_crc16_init
+ * 		purpose: Builds the tables and picks the fastest engine that the processor supports
+ *		and that passes dp_crc16_check_engine.
+ * Return value:
+ * 		None
+ *
+ */
+static void dp_crc16_init(void)
+{
+	unsigned int value;
+	unsigned int table;
+	unsigned char bit;
+
+	for (value = 0u; value < 256u; value++) {
+		table = value;
+		for (bit = 0u; bit < 8u; bit++)
+			table = (table & 0x01u) ? ((table >> 1u) ^ DP_CRC16_POLY) : (table >> 1u);
+		dp_crc16_tables[0][value] = (unsigned short)table;
+	}
+	for (table = 1u; table < 8u; table++) {
+		for (value = 0u; value < 256u; value++) {
+			dp_crc16_tables[table][value] =
+			    (unsigned short)((dp_crc16_tables[table - 1u][value] >> 8u) ^
+					     dp_crc16_tables[0][dp_crc16_tables[table - 1u][value] &
+								0xFFu]);
+		}
+	}
+
+	dp_crc16_engine = dp_crc16_bitwise;
+	if (dp_crc16_check_engine(dp_crc16_table) == TRUE)
+		dp_crc16_engine = dp_crc16_table;
+	if (dp_crc16_check_engine(dp_crc16_slice8) == TRUE)
+		dp_crc16_engine = dp_crc16_slice8;
+#ifdef DP_CRC16_CLMUL
+	if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse2")) {
+		dp_crc16_fold_512 = dp_crc16_fold_constants(512u);
+		dp_crc16_fold_128 = dp_crc16_fold_constants(128u);
+		dp_crc16_clmul_supported = TRUE;
+		if (dp_crc16_check_engine(dp_crc16_clmul) == TRUE)
+			dp_crc16_engine = dp_crc16_clmul;
+	}
+#endif
+	return;
+}
+
+/*
+ * Module: dp_compute_crc
+ * 		purpose: Adds the byte in global_uchar1 to the CRC in global_uint1.
+ * Return value:
+ * 		None
+ *
+ */
+void dp_compute_crc(void)
+{
+	pthread_once(&dp_crc16_once, dp_crc16_init);
+	global_uint1 = (global_uint1 >> 8u) ^ dp_crc16_tables[0][(global_uint1 ^ global_uchar1) & 0xFFu];
 
 	return;
 }
 
+/*
+ * Module: dp_crc16_update
+ * 		purpose: Continues the image CRC (same polynomial as dp_compute_crc) over length
+ *		bytes of data.  Start with 0.
+ * Return value:
+ * 		The updated CRC.
+ *
+ */
+unsigned int dp_crc16_update(unsigned int crc, const unsigned char *data, unsigned long length)
+{
+	pthread_once(&dp_crc16_once, dp_crc16_init);
+	return dp_crc16_engine(crc, data, length);
+}
+
+/*
+ * Module: dp_crc16_use_engine
+ * 		purpose: Makes dp_crc16_update use the given engine instead of the one picked by
+ *		dp_crc16_init, without the self-check, so that tools/dpselftest can cross-check and
+ *		time every engine.  Not to be called while a CRC is being computed.
+ * Return value:
+ * 		FALSE if the engine is not built or the processor does not support it.
+ *
+ */
+unsigned char dp_crc16_use_engine(unsigned char engine)
+{
+	pthread_once(&dp_crc16_once, dp_crc16_init);
+	switch (engine) {
+	case DP_CRC16_ENGINE_BITWISE:
+		dp_crc16_engine = dp_crc16_bitwise;
+		return TRUE;
+	case DP_CRC16_ENGINE_TABLE:
+		dp_crc16_engine = dp_crc16_table;
+		return TRUE;
+	case DP_CRC16_ENGINE_SLICE8:
+		dp_crc16_engine = dp_crc16_slice8;
+		return TRUE;
+#ifdef DP_CRC16_CLMUL
+	case DP_CRC16_ENGINE_CLMUL:
+		if (dp_crc16_clmul_supported == FALSE)
+			return FALSE;
+		dp_crc16_engine = dp_crc16_clmul;
+		return TRUE;
+#endif
+	}
+	return FALSE;
+}
+
 void dp_check_and_get_image_size(void)
 {
 
@@ -29,6 +29,7 @@ extern unsigned long global_ulong1;
 extern unsigned long global_ulong2;
 extern unsigned char global_buf1[global_buf_SIZE]; /* General purpose global_buffer */
 extern unsigned char global_buf2[global_buf_SIZE];
+extern unsigned char image_crc_checked; /* TRUE when the selected image already passed the CRC check */
 
 void dp_flush_global_buf1(void);
 void dp_flush_global_buf2(void);
@@ -37,6 +38,14 @@ void dp_init_vars(void);
  */
 
 void dp_compute_crc(void);
+unsigned int dp_crc16_update(unsigned int crc, const unsigned char *data, unsigned long length);
+/* CRC-16 engines that dp_crc16_use_engine can select, for tools/dpselftest */
+#define DP_CRC16_ENGINE_BITWISE 0u
+#define DP_CRC16_ENGINE_TABLE	1u
+#define DP_CRC16_ENGINE_SLICE8	2u
+#define DP_CRC16_ENGINE_CLMUL	3u
+#define DP_CRC16_ENGINES	4u
+unsigned char dp_crc16_use_engine(unsigned char engine);
 void dp_check_image_crc(void);
 void dp_check_and_get_image_size(void);
 
@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         libdirectc.c                                            */
+/*                                                                          */
+/*  Description:    libdirectc API.  Wraps the transport, image and action  */
+/*  functions and turns the display output into callbacks.                  */
+/*                                                                          */
+/* ************************************************************************ */
+#include "libdirectc.h"
+#include "dpuser.h"
+#include "dpSPIalg.h"
+#include "dpalg.h"
+#include "dpcom.h"
+#include "dpimage.h"
+#include "dptimer.h"
+#include "dputil.h"
+
+#include <string.h>
+
+struct directc_context {
+	struct gpio_handle jtag_gpio;
+	struct directc_callbacks callbacks;
+};
+
+/* The context receiving the engine output.  Output is dropped while none is open. */
+static struct directc_context *directc_active = (struct directc_context *)DPNULL;
+
+#ifdef ENABLE_DISPLAY
+static void directc_display_text(signed char *text)
+{
+	if ((directc_active != DPNULL) && (directc_active->callbacks.log != DPNULL))
+		directc_active->callbacks.log(directc_active->callbacks.user, (const char *)text);
+	return;
+}
+
+static void directc_report_progress(unsigned char value)
+{
+	if ((directc_active != DPNULL) && (directc_active->callbacks.progress != DPNULL))
+		directc_active->callbacks.progress(directc_active->callbacks.user, value);
+	return;
+}
+#endif
+
+static void directc_install_hooks(void)
+{
+#ifdef ENABLE_DISPLAY
+	dp_display_hook = directc_display_text;
+	dp_progress_hook = directc_report_progress;
+#endif
+	return;
+}
+
+directc_context *directc_open(const struct directc_callbacks *callbacks)
+{
+	struct directc_context *context;
+
+	if (directc_active != DPNULL)
+		return (directc_context *)DPNULL;
+
+	context = (struct directc_context *)dp_malloc(sizeof(struct directc_context));
+	if (context == DPNULL)
+		return (directc_context *)DPNULL;
+	memset(context, 0, sizeof(struct directc_context));
+	if (callbacks != DPNULL)
+		context->callbacks = *callbacks;
+
+	directc_install_hooks();
+	directc_active = context;
+	/* A cancellation left over from a previous context does not apply to this one */
+	dp_cancel_requested = 0;
+	if (gpio_config(&context->jtag_gpio) != 0) {
+		directc_active = (struct directc_context *)DPNULL;
+		dp_free(context);
+		return (directc_context *)DPNULL;
+	}
+	return context;
+}
+
+void directc_close(directc_context *context)
+{
+	if (context == DPNULL)
+		return;
+	if (directc_active == context)
+		directc_active = (struct directc_context *)DPNULL;
+	gpio_release(&context->jtag_gpio);
+	dp_free(context);
+	return;
+}
+
+/*
+ * Module: directc_validate_image
+ * 		purpose: Runs the CRC check of a freshly loaded image so that actions do not
+ *		repeat it.
+ * Return value:
+ * 		The image, or DPNULL after freeing it if the CRC does not match.
+ *
+ */
+static directc_image *directc_validate_image(directc_image *image, int *status)
+{
+	directc_install_hooks();
+	dp_select_image(image);
+	error_code = DPE_SUCCESS;
+	dp_check_image_crc();
+	if (error_code != DPE_SUCCESS) {
+		*status = DP_IMAGE_CRC_ERROR;
+		directc_image_free(image);
+		return (directc_image *)DPNULL;
+	}
+	image->crc_checked = TRUE;
+	*status = DIRECTC_SUCCESS;
+	return image;
+}
+
+directc_image *directc_image_from_memory(const void *data, unsigned long size, int *status)
+{
+	directc_image *image;
+
+	image = (directc_image *)dp_malloc(sizeof(directc_image));
+	if (image == DPNULL) {
+		*status = DP_IMAGE_MEMORY_ERROR;
+		return (directc_image *)DPNULL;
+	}
+	memset(image, 0, sizeof(directc_image));
+	image->buffer = (unsigned char *)dp_malloc(size);
+	if (image->buffer == DPNULL) {
+		*status = DP_IMAGE_MEMORY_ERROR;
+		dp_free(image);
+		return (directc_image *)DPNULL;
+	}
+	memcpy(image->buffer, data, size);
+	image->size = size;
+	image->fd = -1;
+	image->loaded = TRUE;
+	return directc_validate_image(image, status);
+}
+
+directc_image *directc_image_from_file(const char *path, int *status)
+{
+	directc_image *image;
+
+	image = (directc_image *)dp_malloc(sizeof(directc_image));
+	if (image == DPNULL) {
+		*status = DP_IMAGE_MEMORY_ERROR;
+		return (directc_image *)DPNULL;
+	}
+	directc_install_hooks();
+	*status = dp_load_image((signed char *)path, image);
+	if (*status != DP_IMAGE_LOADED) {
+		directc_image_free(image);
+		return (directc_image *)DPNULL;
+	}
+	return directc_validate_image(image, status);
+}
+
+void directc_image_free(directc_image *image)
+{
+	if (image == DPNULL)
+		return;
+	if (image_buffer == image->buffer)
+		image_buffer = (unsigned char *)DPNULL;
+#ifdef USE_PAGING
+	if ((image->fd >= 0) && (image_fd == image->fd))
+		image_fd = -1;
+#endif
+	dp_unload_image(image);
+	dp_free(image);
+	return;
+}
+
+int directc_run(directc_context *context, const char *action, directc_image *image,
+		unsigned long spi_address)
+{
+	unsigned long start_time;
+	int result;
+
+#ifndef ENABLE_SPI_FLASH_SUPPORT
+	(void)spi_address;
+#endif
+	start_time = dp_timer_ms();
+	directc_install_hooks();
+	Action_code = dp_get_Action_code((signed char *)action);
+	if (Action_code == DP_NO_ACTION_FOUND) {
+		result = DPE_ACTION_NOT_FOUND;
+	} else if (image == DPNULL) {
+		result = DP_IMAGE_REQUIRED_ERROR;
+		if (dp_image_required(Action_code) == FALSE) {
+			dp_deselect_image();
+#ifdef ENABLE_SPI_FLASH_SUPPORT
+			spi_target_address = spi_address;
+#endif
+			result = dp_top(&context->jtag_gpio);
+		}
+	} else {
+		dp_select_image(image);
+#ifdef ENABLE_SPI_FLASH_SUPPORT
+		spi_target_address = spi_address;
+#endif
+		result = dp_top(&context->jtag_gpio);
+	}
+	if (context->callbacks.result != DPNULL)
+		context->callbacks.result(context->callbacks.user, action, result,
+					  (long)(dp_timer_ms() - start_time));
+	return result;
+}
+
+void directc_set_time_budget(directc_context *context, unsigned long action_ms,
+			     unsigned long operation_ms)
+{
+	(void)context;
+	dp_action_time_budget = action_ms;
+	dp_operation_time_budget = operation_ms;
+	return;
+}
+
+void directc_cancel(directc_context *context)
+{
+	(void)context;
+	dp_timer_cancel();
+	return;
+}
+
+/*   *************** End of File *************** */
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         libdirectc.h                                            */
+/*                                                                          */
+/*  Description:    Public interface of libdirectc for applications that    */
+/*  embed DirectC instead of running directc_programmer                     */
+/*                                                                          */
+/* ************************************************************************ */
+
+#ifndef INC_LIBDIRECTC_H
+#define INC_LIBDIRECTC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The programming engine keeps its state in global variables, so only one context
+ * can be open at a time and calls must not be made concurrently from several threads.
+ * Images are independent of the context.  They are CRC checked once when they are
+ * loaded and can be used for any number of actions.
+ *
+ * Error codes are the DPE_* codes of dpalg.h and the DP_IMAGE_* exit status values
+ * of dpimage.h.
+ */
+#define DIRECTC_SUCCESS 0
+
+typedef struct directc_context directc_context;
+typedef struct dp_image directc_image;
+
+struct directc_callbacks {
+	/* Text normally written to stdout by the engine */
+	void (*log)(void *user, const char *text);
+	/* Percentage of the current component or operation */
+	void (*progress)(void *user, unsigned int percent);
+	/* Called once at the end of every directc_run */
+	void (*result)(void *user, const char *action, int error_code, long elapsed_ms);
+	void *user;
+};
+
+/* Claims the JTAG GPIO lines.  Returns NULL on failure or if a context is already open. */
+directc_context *directc_open(const struct directc_callbacks *callbacks);
+void directc_close(directc_context *context);
+
+/* The data is copied.  status receives the load or CRC error code. */
+directc_image *directc_image_from_memory(const void *data, unsigned long size, int *status);
+directc_image *directc_image_from_file(const char *path, int *status);
+void directc_image_free(directc_image *image);
+
+/*
+ * Runs the named action ("program", "verify", "spi_flash_program", ...).  image can be NULL for
+ * the actions that only access the device, such as "read_idcode" and "device_info".
+ */
+int directc_run(directc_context *context, const char *action, directc_image *image,
+		unsigned long spi_address);
+
+/*
+ * Wall-clock budgets in milliseconds for a whole action and for a single poll
+ * operation.  0 disables a budget.  An action that runs out of time fails with
+ * DPE_TIME_BUDGET_EXCEEDED (156).
+ */
+void directc_set_time_budget(directc_context *context, unsigned long action_ms,
+			     unsigned long operation_ms);
+/* May be called from a signal handler or another thread while directc_run is
+ * in progress.  The action fails with DPE_ACTION_CANCELLED (155).  Called
+ * between runs, it cancels the next directc_run. */
+void directc_cancel(directc_context *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_LIBDIRECTC_H */
+
+/*   *************** End of File *************** */
@@ -0,0 +1,414 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpgendat.c                                              */
+/*                                                                          */
+/*  Description:    Writes synthetic PolarFire DAT files of a given shape   */
+/*  to benchmark loading, CRC, paging and the frame loop.  The files follow */
+/*  the layout read by dpcom.c and dpG5alg.c but hold random frames, so     */
+/*  they must never be programmed into a real device.                       */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dpuser.h"
+#include "dpalg.h"
+#include "dpcom.h"
+#include "dpG5alg.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Header up to the device exception byte, then the number of blocks of the directory */
+#define GENDAT_HEADER_SIZE	 72u
+#define GENDAT_BLOCKS		 5u
+/* Largest block count of a component, the counts are packed in 22 bits */
+#define GENDAT_MAX_BLOCKS	 0x3FFFFFu
+/* The frames of a component header up to G5M_GEN_CERT_BYTE */
+#define GENDAT_MIN_BLOCKS	 22u
+#define GENDAT_MAX_COMPONENTS	 4096u
+#define GENDAT_CHUNK		 65536u
+
+struct gendat_options {
+	unsigned long size;
+	unsigned int components;
+	unsigned long blocks[GENDAT_MAX_COMPONENTS];
+	unsigned int erase_components;
+	unsigned long erase_blocks;
+	unsigned long idcode;
+	unsigned long id_mask;
+	unsigned char family;
+	unsigned char exception;
+	unsigned int bsr_bits;
+	unsigned long long seed;
+	unsigned char bad_crc;
+	char *path;
+};
+
+static unsigned short gendat_crc_table[256];
+static unsigned long long gendat_state;
+static unsigned char gendat_chunk[GENDAT_CHUNK];
+
+/* Same CRC as dp_compute_crc: reflected 0x8408, initial value 0 */
+static void gendat_crc_init(void)
+{
+	unsigned int value;
+	unsigned int bit;
+	unsigned short crc;
+
+	for (value = 0u; value < 256u; value++) {
+		crc = (unsigned short)value;
+		for (bit = 0u; bit < 8u; bit++)
+			crc = (crc & 1u) ? (unsigned short)((crc >> 1) ^ 0x8408u)
+					 : (unsigned short)(crc >> 1);
+		gendat_crc_table[value] = crc;
+	}
+	return;
+}
+
+static unsigned short gendat_crc(unsigned short crc, unsigned char *data, unsigned long length)
+{
+	while (length--)
+		crc = (unsigned short)((crc >> 8) ^ gendat_crc_table[(crc ^ *data++) & 0xffu]);
+	return crc;
+}
+
+/* xorshift64, fast enough that writing the file is the bottleneck */
+static void gendat_random(unsigned char *data, unsigned long length)
+{
+	unsigned long long value = 0u;
+	unsigned long index;
+
+	for (index = 0u; index < length; index++) {
+		if ((index & 7u) == 0u) {
+			gendat_state ^= gendat_state << 13;
+			gendat_state ^= gendat_state >> 7;
+			gendat_state ^= gendat_state << 17;
+			value = gendat_state;
+		}
+		data[index] = (unsigned char)value;
+		value >>= 8;
+	}
+	return;
+}
+
+static void gendat_put(unsigned char *data, unsigned long offset, unsigned long value,
+		       unsigned int bytes)
+{
+	while (bytes--) {
+		data[offset++] = (unsigned char)value;
+		value >>= 8;
+	}
+	return;
+}
+
+/*
+ * Module: gendat_write
+ * 		purpose: Writes data to the output and adds it to the CRC.
+ * Return value:
+ * 		0 on success, 1 if the write failed.
+ *
+ */
+static int gendat_write(FILE *output, unsigned short *crc, unsigned char *data,
+			unsigned long length)
+{
+	*crc = gendat_crc(*crc, data, length);
+	return (fwrite(data, 1u, length, output) == length) ? 0 : 1;
+}
+
+/*
+ * Module: gendat_write_component
+ * 		purpose: Writes the random frames of a component.  The component type is set in its
+ *		first frames, and the certificate request bit is cleared so that program does not
+ *		read a certificate for it.
+ * Return value:
+ * 		0 on success, 1 if the write failed.
+ *
+ */
+static int gendat_write_component(FILE *output, unsigned short *crc, unsigned long blocks,
+				  unsigned char type)
+{
+	unsigned long remaining = blocks * G5M_FRAME_BYTE_LENGTH;
+	unsigned long length;
+	unsigned char first = TRUE;
+
+	while (remaining != 0u) {
+		length = (remaining < GENDAT_CHUNK) ? remaining : GENDAT_CHUNK;
+		gendat_random(gendat_chunk, length);
+		if (first == TRUE) {
+			gendat_chunk[G5M_COMPONENT_TYPE_IN_HEADER_BYTE] = type;
+			gendat_chunk[G5M_GEN_CERT_BYTE] &= (unsigned char)~0x2u;
+			first = FALSE;
+		}
+		if (gendat_write(output, crc, gendat_chunk, length) != 0)
+			return 1;
+		remaining -= length;
+	}
+	return 0;
+}
+
+static unsigned long gendat_parse_size(char *text)
+{
+	char *end;
+	unsigned long value;
+
+	value = strtoul(text, &end, 0);
+	if ((*end == 'k') || (*end == 'K'))
+		value *= 1024u;
+	else if ((*end == 'm') || (*end == 'M'))
+		value *= 1024u * 1024u;
+	else if ((*end == 'g') || (*end == 'G'))
+		value *= 1024u * 1024u * 1024u;
+	return value;
+}
+
+static void gendat_usage(void)
+{
+	printf("Usage: dpgendat [options] <output file | ->\n");
+	printf("--size=<bytes>[k|m|g], Size of the datastream, split over the components (default 64k)\n");
+	printf("--components=<n>, Number of program components, more are used if the size needs them\n");
+	printf("--blocks=<n>,<n>,..., Block count of each program component, overrides --size\n");
+	printf("--erase-blocks=<n>, Block count of the erase component, 0 for none (default 32)\n");
+	printf("--idcode=<id>, IDCODE the file is built for (default 0x0F8151CF)\n");
+	printf("--mask=<mask>, IDCODE mask (default 0x0FFFFFFF)\n");
+	printf("--family=<n>, 7 for PolarFire, 8 for PolarFire SoC (default 7)\n");
+	printf("--exception=<n>, Device exception byte (default 0)\n");
+	printf("--bsr-bits=<n>, Length of the boundary scan register (default 2048)\n");
+	printf("--seed=<n>, Seed of the random frames (default 1)\n");
+	printf("--bad-crc, Stores a wrong CRC\n");
+	return;
+}
+
+/*
+ * Module: gendat_parse
+ * 		purpose: Reads the command line into options and splits the datastream size over
+ *		the components when no block counts are given.
+ * Return value:
+ * 		0 on success, 1 on a usage error.
+ *
+ */
+static int gendat_parse(int argc, char **argv, struct gendat_options *options)
+{
+	unsigned long total_blocks;
+	unsigned long share;
+	unsigned int component;
+	unsigned char explicit_blocks = FALSE;
+	char *next;
+	int arg;
+
+	memset(options, 0, sizeof(*options));
+	options->size = 65536u;
+	options->components = 2u;
+	options->erase_blocks = 32u;
+	options->idcode = 0x0F8151CFu;
+	options->id_mask = 0x0FFFFFFFu;
+	options->family = G5M_FAMILY_ID_IN_DAT;
+	options->bsr_bits = 2048u;
+	options->seed = 1u;
+
+	for (arg = 1; arg < argc; arg++) {
+		if (strncmp(argv[arg], "--size=", 7) == 0) {
+			options->size = gendat_parse_size(&argv[arg][7]);
+		} else if (strncmp(argv[arg], "--components=", 13) == 0) {
+			options->components = (unsigned int)strtoul(&argv[arg][13], (char **)DPNULL, 0);
+		} else if (strncmp(argv[arg], "--blocks=", 9) == 0) {
+			explicit_blocks = TRUE;
+			options->components = 0u;
+			next = &argv[arg][9];
+			while ((*next != '\0') && (options->components < GENDAT_MAX_COMPONENTS)) {
+				options->blocks[options->components++] = strtoul(next, &next, 0);
+				if (*next == ',')
+					next++;
+			}
+		} else if (strncmp(argv[arg], "--erase-blocks=", 15) == 0) {
+			options->erase_blocks = strtoul(&argv[arg][15], (char **)DPNULL, 0);
+		} else if (strncmp(argv[arg], "--idcode=", 9) == 0) {
+			options->idcode = strtoul(&argv[arg][9], (char **)DPNULL, 16);
+		} else if (strncmp(argv[arg], "--mask=", 7) == 0) {
+			options->id_mask = strtoul(&argv[arg][7], (char **)DPNULL, 16);
+		} else if (strncmp(argv[arg], "--family=", 9) == 0) {
+			options->family = (unsigned char)strtoul(&argv[arg][9], (char **)DPNULL, 0);
+		} else if (strncmp(argv[arg], "--exception=", 12) == 0) {
+			options->exception = (unsigned char)strtoul(&argv[arg][12], (char **)DPNULL, 0);
+		} else if (strncmp(argv[arg], "--bsr-bits=", 11) == 0) {
+			options->bsr_bits = (unsigned int)strtoul(&argv[arg][11], (char **)DPNULL, 0);
+		} else if (strncmp(argv[arg], "--seed=", 7) == 0) {
+			options->seed = strtoull(&argv[arg][7], (char **)DPNULL, 0);
+		} else if (strcmp(argv[arg], "--bad-crc") == 0) {
+			options->bad_crc = TRUE;
+		} else if ((argv[arg][0] == '-') && (argv[arg][1] != '\0')) {
+			return 1;
+		} else {
+			options->path = argv[arg];
+		}
+	}
+	if ((options->path == (char *)DPNULL) || (options->bsr_bits == 0u) ||
+	    (options->bsr_bits > MAX_BSR_BIT_SIZE) || (options->components == 0u))
+		return 1;
+
+	if (explicit_blocks == FALSE) {
+		total_blocks = options->size / G5M_FRAME_BYTE_LENGTH;
+		if (total_blocks < options->components * GENDAT_MIN_BLOCKS)
+			total_blocks = options->components * GENDAT_MIN_BLOCKS;
+		if (total_blocks / GENDAT_MAX_BLOCKS >= options->components)
+			options->components = (unsigned int)(total_blocks / GENDAT_MAX_BLOCKS) + 1u;
+		if (options->components > GENDAT_MAX_COMPONENTS)
+			return 1;
+		for (component = 0u; component < options->components; component++) {
+			share = total_blocks / (options->components - component);
+			options->blocks[component] = share;
+			total_blocks -= share;
+		}
+	}
+	for (component = 0u; component < options->components; component++) {
+		if ((options->blocks[component] < GENDAT_MIN_BLOCKS) ||
+		    (options->blocks[component] > GENDAT_MAX_BLOCKS))
+			return 1;
+	}
+	if (options->erase_blocks != 0u) {
+		if ((options->erase_blocks < GENDAT_MIN_BLOCKS) ||
+		    (options->erase_blocks > GENDAT_MAX_BLOCKS))
+			return 1;
+		options->erase_components = 1u;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct gendat_options options;
+	unsigned char header[GENDAT_HEADER_SIZE + GENDAT_BLOCKS * BTYES_PER_TABLE_RECORD];
+	unsigned char *tables;
+	unsigned long block_address[GENDAT_BLOCKS];
+	unsigned long block_length[GENDAT_BLOCKS];
+	unsigned char block_ID[GENDAT_BLOCKS] = {G5M_BsrPattern_ID, G5M_BsrPatternMask_ID,
+						 G5M_NUMBER_OF_BLOCKS_ID, G5M_datastream_ID,
+						 G5M_erasedatastream_ID};
+	unsigned long long total_size;
+	unsigned long tables_length;
+	unsigned long bsr_bytes;
+	unsigned long datastream = 0u;
+	unsigned long bit;
+	unsigned long count;
+	unsigned int byte;
+	unsigned int num_components;
+	unsigned int component;
+	unsigned int block;
+	unsigned short crc = 0u;
+	unsigned char trailer[2];
+	FILE *output;
+	int failed = 0;
+
+	if (gendat_parse(argc, argv, &options) != 0) {
+		gendat_usage();
+		return 1;
+	}
+	gendat_crc_init();
+	gendat_state = (options.seed != 0u) ? options.seed : 1u;
+
+	/* The BSR pattern, its mask and the packed block counts of all the components */
+	num_components = options.components + options.erase_components;
+	bsr_bytes = (options.bsr_bits + 7u) / 8u;
+	block_length[0] = bsr_bytes;
+	block_length[1] = bsr_bytes;
+	block_length[2] = ((num_components - 1u) * 22u) / 8u + 4u;
+	tables_length = block_length[0] + block_length[1] + block_length[2];
+	tables = (unsigned char *)calloc(tables_length, 1u);
+	if (tables == (unsigned char *)DPNULL) {
+		printf("Error: can't allocate memory\n");
+		return 1;
+	}
+	gendat_random(tables, bsr_bytes);
+	memset(&tables[bsr_bytes], 0xff, bsr_bytes);
+	for (component = 0u; component < num_components; component++) {
+		bit = (unsigned long)component * 22u;
+		count = (component < options.components) ? options.blocks[component]
+							 : options.erase_blocks;
+		count <<= bit % 8u;
+		for (byte = 0u; byte < 4u; byte++)
+			tables[2u * bsr_bytes + bit / 8u + byte] |= (unsigned char)(count >> (8u * byte));
+	}
+	for (component = 0u; component < options.components; component++)
+		datastream += options.blocks[component] * G5M_FRAME_BYTE_LENGTH;
+	block_length[3] = datastream;
+	block_length[4] = options.erase_blocks * G5M_FRAME_BYTE_LENGTH;
+
+	block_address[0] = sizeof(header);
+	for (block = 1u; block < GENDAT_BLOCKS; block++)
+		block_address[block] = block_address[block - 1u] + block_length[block - 1u];
+	total_size = (unsigned long long)block_address[GENDAT_BLOCKS - 1u] +
+		     block_length[GENDAT_BLOCKS - 1u] + 2u;
+	if (total_size > 0xFFFFFFFFu) {
+		printf("Error: the image size field holds 32 bits, the file would be %llu bytes\n",
+		       total_size);
+		free(tables);
+		return 1;
+	}
+
+	memset(header, 0, sizeof(header));
+	gendat_put(header, 0u, 0x2D4D3547u, 4u); /* "G5M-" */
+	header[HEADER_SIZE_OFFSET] = GENDAT_HEADER_SIZE;
+	gendat_put(header, IMAGE_SIZE_OFFSET, (unsigned long)total_size, 4u);
+	header[G5M_DEVICE_FAMILY_OFFSET] = options.family;
+	gendat_put(header, G5M_ID_OFFSET, options.idcode, G5M_ID_BYTE_LENGTH);
+	gendat_put(header, G5M_ID_MASK_OFFSET, options.id_mask, G5M_ID_MASK_BYTE_LENGTH);
+	gendat_put(header, G5M_NUMOFBSRBITS_OFFSET, options.bsr_bits,
+		   G5M_NUMOFBSRBITS_BYTE_LENGTH);
+	gendat_put(header, G5M_NUMOFCOMPONENT_OFFSET, num_components,
+		   G5M_NUMOFCOMPONENT_BYTE_LENGTH);
+	gendat_put(header, G5M_DATASIZE_OFFSET, options.components, G5M_DATASIZE_BYTE_LENGTH);
+	gendat_put(header, G5M_ERASEDATASIZE_OFFSET, options.erase_components,
+		   G5M_ERASEDATASIZE_BYTE_LENGTH);
+	header[G5M_DEVICE_EXCEPTION_OFFSET] = options.exception;
+	header[GENDAT_HEADER_SIZE - 1u] = GENDAT_BLOCKS;
+	for (block = 0u; block < GENDAT_BLOCKS; block++) {
+		header[GENDAT_HEADER_SIZE + block * BTYES_PER_TABLE_RECORD] = block_ID[block];
+		gendat_put(header, GENDAT_HEADER_SIZE + block * BTYES_PER_TABLE_RECORD + 1u,
+			   block_address[block], 4u);
+		gendat_put(header, GENDAT_HEADER_SIZE + block * BTYES_PER_TABLE_RECORD + 5u,
+			   block_length[block], 4u);
+	}
+
+	if (strcmp(options.path, "-") == 0) {
+		output = stdout;
+	} else {
+		output = fopen(options.path, "wb");
+		if (output == (FILE *)DPNULL) {
+			printf("Error: can't create %s\n", options.path);
+			free(tables);
+			return 1;
+		}
+	}
+
+	failed |= gendat_write(output, &crc, header, sizeof(header));
+	failed |= gendat_write(output, &crc, tables, tables_length);
+	/* The first component carries the bitstream digest, the others are fabric data */
+	for (component = 0u; (component < options.components) && (failed == 0); component++)
+		failed |= gendat_write_component(output, &crc, options.blocks[component],
+						 (component == 0u) ? G5M_COMP_BITS : G5M_COMP_FPGA);
+	if ((options.erase_components != 0u) && (failed == 0))
+		failed |= gendat_write_component(output, &crc, options.erase_blocks, G5M_COMP_FPGA);
+	if (options.bad_crc == TRUE)
+		crc ^= 1u;
+	gendat_put(trailer, 0u, crc, 2u);
+	if (failed == 0)
+		failed |= (fwrite(trailer, 1u, 2u, output) == 2u) ? 0 : 1;
+	if (output != stdout)
+		failed |= (fclose(output) == 0) ? 0 : 1;
+	else
+		failed |= (fflush(output) == 0) ? 0 : 1;
+	free(tables);
+
+	if (failed != 0) {
+		fprintf(stderr, "Error: writing %s failed\n", options.path);
+		return 1;
+	}
+	fprintf(stderr, "%s: %llu bytes, %u program and %u erase components, CRC %04X\n",
+		options.path, total_size, options.components, options.erase_components, crc);
+	return 0;
+}
+
+/*   *************** End of File *************** */
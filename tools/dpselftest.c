@@ -0,0 +1,572 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2023 Microchip Technology Inc. All rights reserved.
+ */
+
+/* ************************************************************************ */
+/*                                                                          */
+/*  Module:         dpselftest.c                                            */
+/*                                                                          */
+/*  Description:    Cross-checks the fast paths of the engine against plain */
+/*  references.  Every CRC-16 engine is run over random buffers, lengths    */
+/*  and alignments and compared with a bitwise CRC, then timed.  Every DAT  */
+/*  file given is read through the block directory and the direct field     */
+/*  reads and compared with a linear scan of the file bytes, then the       */
+/*  access patterns of load_bsr and process_data are timed both ways.  No   */
+/*  JTAG access is made.                                                    */
+/*                                                                          */
+/* ************************************************************************ */
+#include "dpuser.h"
+#include "dpalg.h"
+#include "dpcom.h"
+#include "dpG5alg.h"
+#include "dpimage.h"
+#include "dptimer.h"
+#include "dputil.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Random buffers of up to SELFTEST_CRC_MAX_LENGTH bytes at offsets 0 to 15 */
+#define SELFTEST_CRC_BUFFER	 (SELFTEST_CRC_MAX_LENGTH + 16u)
+#define SELFTEST_CRC_MAX_LENGTH	 4096u
+#define SELFTEST_CRC_RUNS	 4000u
+#define SELFTEST_BENCH_SIZE	 (4u * 1024u * 1024u)
+#define SELFTEST_BENCH_PASSES	 4u
+/* Random field reads per block of a DAT file */
+#define SELFTEST_FIELD_READS	 4096u
+/* Image reads timed per access pattern */
+#define SELFTEST_PATTERN_READS	 4000000u
+
+static const char *selftest_engine_names[DP_CRC16_ENGINES] = {"bitwise", "table", "slice8",
+							     "clmul"};
+static unsigned long long selftest_state = 1u;
+
+/* The DAT file and the block found last by the scan, see selftest_scan_block_address */
+static unsigned char *scan_file;
+static unsigned long scan_file_size;
+static unsigned char scan_var_ID;
+static unsigned long scan_block_address;
+
+/* Reads the image either through dpcom.c or through the scan */
+struct selftest_reader {
+	unsigned long (*get_bytes)(unsigned char var_ID, unsigned long byte_index,
+				   unsigned char bytes_requested);
+	unsigned long (*get_header_bytes)(unsigned long byte_index, unsigned char bytes_requested);
+	unsigned char *(*get_data)(unsigned char var_ID, unsigned long bit_index);
+};
+
+/* xorshift64, as in dpgendat */
+static unsigned long selftest_next(void)
+{
+	selftest_state ^= selftest_state << 13;
+	selftest_state ^= selftest_state >> 7;
+	selftest_state ^= selftest_state << 17;
+	return (unsigned long)(selftest_state >> 16);
+}
+
+static void selftest_random(unsigned char *data, unsigned long length)
+{
+	unsigned long index;
+
+	for (index = 0u; index < length; index++)
+		data[index] = (unsigned char)selftest_next();
+	return;
+}
+
+/* Reference CRC, one bit at a time, independent of the tables in dputil.c */
+static unsigned int selftest_crc_reference(unsigned int crc, const unsigned char *data,
+					   unsigned long length)
+{
+	unsigned char bit;
+
+	while (length--) {
+		crc ^= *data++;
+		for (bit = 0u; bit < 8u; bit++)
+			crc = (crc & 1u) ? ((crc >> 1) ^ 0x8408u) : (crc >> 1);
+	}
+	return crc;
+}
+
+/*
+ * Module: selftest_crc
+ * 		purpose: Compares every engine with the reference over random data, lengths, start
+ *		offsets and initial CRC values, and over lengths 0 to 300 at every offset, then
+ *		reports the throughput of each engine.
+ * Return value:
+ * 		Number of mismatches.
+ *
+ */
+static unsigned long selftest_crc(void)
+{
+	unsigned char buffer[SELFTEST_CRC_BUFFER];
+	unsigned char *bench;
+	unsigned long failures = 0u;
+	unsigned long engine_failures;
+	unsigned long run;
+	unsigned long length;
+	unsigned long offset;
+	unsigned long long elapsed_ns;
+	unsigned int crc;
+	unsigned int expected;
+	unsigned int pass;
+	unsigned char engine;
+
+	bench = (unsigned char *)malloc(SELFTEST_BENCH_SIZE);
+	if (bench == (unsigned char *)DPNULL) {
+		printf("Error: can't allocate memory\n");
+		return 1u;
+	}
+	selftest_random(bench, SELFTEST_BENCH_SIZE);
+	expected = selftest_crc_reference(0u, bench, SELFTEST_BENCH_SIZE);
+
+	printf("CRC-16 engines:\n");
+	for (engine = 0u; engine < DP_CRC16_ENGINES; engine++) {
+		if (dp_crc16_use_engine(engine) == FALSE) {
+			printf("  %-8s not supported\n", selftest_engine_names[engine]);
+			continue;
+		}
+		engine_failures = 0u;
+		for (offset = 0u; offset < 16u; offset++) {
+			selftest_random(buffer, SELFTEST_CRC_BUFFER);
+			for (length = 0u; length <= 300u; length++) {
+				if (dp_crc16_update(0x1D0Fu, &buffer[offset], length) !=
+				    selftest_crc_reference(0x1D0Fu, &buffer[offset], length))
+					engine_failures++;
+			}
+		}
+		for (run = 0u; run < SELFTEST_CRC_RUNS; run++) {
+			offset = selftest_next() % 16u;
+			length = selftest_next() % (SELFTEST_CRC_MAX_LENGTH + 1u);
+			crc = (unsigned int)(selftest_next() & 0xFFFFu);
+			selftest_random(&buffer[offset], length);
+			if (dp_crc16_update(crc, &buffer[offset], length) !=
+			    selftest_crc_reference(crc, &buffer[offset], length))
+				engine_failures++;
+		}
+
+		elapsed_ns = dp_timer_ns();
+		for (pass = 0u; pass < SELFTEST_BENCH_PASSES; pass++) {
+			if (dp_crc16_update(0u, bench, SELFTEST_BENCH_SIZE) != expected)
+				engine_failures++;
+		}
+		elapsed_ns = dp_timer_ns() - elapsed_ns;
+		printf("  %-8s %s, %8.1f MB/s\n", selftest_engine_names[engine],
+		       (engine_failures == 0u) ? "matches" : "MISMATCH",
+		       (elapsed_ns != 0u) ? (double)SELFTEST_BENCH_SIZE * SELFTEST_BENCH_PASSES * 1000.0 /
+						(double)elapsed_ns
+					  : 0.0);
+		failures += engine_failures;
+	}
+	free(bench);
+	return failures;
+}
+
+static unsigned long selftest_load_le(const unsigned char *data, unsigned char bytes)
+{
+	unsigned long value = 0u;
+
+	while (bytes--)
+		value = (value << 8) | data[bytes];
+	return value;
+}
+
+/*
+ * Module: selftest_dat_block
+ * 		purpose: Compares the length of block var_ID and random 1 to 4 byte reads from it,
+ *		including reads that cross the end of the block, with the file bytes.  A read past
+ *		the end of a block returns the bytes up to its end.
+ * Return value:
+ * 		Number of mismatches.
+ *
+ */
+static unsigned long selftest_dat_block(unsigned char var_ID, unsigned char *file,
+					unsigned long address, unsigned long length)
+{
+	unsigned long failures = 0u;
+	unsigned long read;
+	unsigned long index;
+	unsigned long expected;
+	unsigned char bytes;
+
+	if (dp_get_block_length(var_ID) != length) {
+		printf("  block %u: length %lu, the file says %lu\n", var_ID,
+		       dp_get_block_length(var_ID), length);
+		return 1u;
+	}
+	for (read = 0u; (read < SELFTEST_FIELD_READS) && (length != 0u); read++) {
+		bytes = (unsigned char)(1u + selftest_next() % 4u);
+		/* One read in eight is placed over the end of the block */
+		if ((read % 8u) == 0u)
+			index = (length > 3u) ? length - 1u - selftest_next() % 3u : 0u;
+		else
+			index = selftest_next() % length;
+		expected = selftest_load_le(&file[address + index],
+					    (index + bytes > length) ? (unsigned char)(length - index)
+								     : bytes);
+		if (dp_get_bytes(var_ID, index, bytes) != expected) {
+			if (failures == 0u)
+				printf("  block %u: %u bytes at %lu read 0x%lX, the file holds 0x%lX\n",
+				       var_ID, bytes, index, dp_get_bytes(var_ID, index, bytes),
+				       expected);
+			failures++;
+		}
+	}
+	return failures;
+}
+
+/*
+ * The scan below reads the image the way dpcom.c did before the block directory and the direct
+ * field reads: the lookup table is searched, one header byte at a time, whenever the block ID
+ * changes, and every field is combined one byte at a time.  It serves as the baseline of the
+ * pattern timings.  Its functions are not inlined, like the dpcom.c functions they stand for.
+ */
+static __attribute__((noinline)) unsigned long
+selftest_scan_header_bytes(unsigned long byte_index, unsigned char bytes_requested)
+{
+	unsigned long ret = 0u;
+	unsigned char i;
+
+	if (byte_index + bytes_requested > scan_file_size)
+		return 0u;
+	for (i = 0u; i < bytes_requested; i++)
+		ret |= ((unsigned long)scan_file[byte_index + i]) << (i * 8u);
+	return ret;
+}
+
+static __attribute__((noinline)) void selftest_scan_block_address(unsigned char requested_var_ID)
+{
+	unsigned long table;
+	unsigned int num_vars;
+	unsigned int var_idx;
+
+	if (scan_var_ID == requested_var_ID)
+		return;
+	scan_block_address = 0u;
+	scan_var_ID = Header_ID;
+	if (requested_var_ID == Header_ID)
+		return;
+	table = selftest_scan_header_bytes(HEADER_SIZE_OFFSET, 1u);
+	num_vars = (unsigned int)selftest_scan_header_bytes(table - 1u, 1u);
+	for (var_idx = 0u; var_idx < num_vars; var_idx++) {
+		if (selftest_scan_header_bytes(table + BTYES_PER_TABLE_RECORD * var_idx, 1u) ==
+		    requested_var_ID) {
+			scan_block_address = selftest_scan_header_bytes(
+			    table + BTYES_PER_TABLE_RECORD * var_idx + 1u, 4u);
+			scan_var_ID = requested_var_ID;
+			break;
+		}
+	}
+	return;
+}
+
+static __attribute__((noinline)) unsigned char *selftest_scan_data(unsigned char var_ID,
+								    unsigned long bit_index)
+{
+	selftest_scan_block_address(var_ID);
+	if (((scan_block_address == 0u) && (var_ID != Header_ID)) ||
+	    (scan_block_address + bit_index / 8u >= scan_file_size))
+		return (unsigned char *)DPNULL;
+	return &scan_file[scan_block_address + bit_index / 8u];
+}
+
+static __attribute__((noinline)) unsigned long
+selftest_scan_bytes(unsigned char var_ID, unsigned long byte_index, unsigned char bytes_requested)
+{
+	unsigned char *data;
+	unsigned long ret = 0u;
+	unsigned char i;
+
+	data = selftest_scan_data(var_ID, byte_index * 8u);
+	if ((data == (unsigned char *)DPNULL) ||
+	    (scan_block_address + byte_index + bytes_requested > scan_file_size))
+		return 0u;
+	for (i = 0u; i < bytes_requested; i++)
+		ret |= ((unsigned long)data[i]) << (i * 8u);
+	return ret;
+}
+
+static const struct selftest_reader selftest_scan_reader = {
+    selftest_scan_bytes, selftest_scan_header_bytes, selftest_scan_data};
+static const struct selftest_reader selftest_directory_reader = {
+    dp_get_bytes, dp_get_header_bytes, dp_get_data};
+
+/* The BSR merge of dp_G5M_load_bsr before dp_get_block_span: pattern and mask byte pairs */
+static unsigned long selftest_pattern_load_bsr(const struct selftest_reader *reader,
+					       unsigned long *reads)
+{
+	unsigned long bsr_bytes;
+	unsigned long index;
+	unsigned long sum = 0u;
+
+	bsr_bytes = (reader->get_header_bytes(G5M_NUMOFBSRBITS_OFFSET, G5M_NUMOFBSRBITS_BYTE_LENGTH) +
+		     7u) / 8u;
+	for (index = 0u; index < bsr_bytes; index++) {
+		sum += reader->get_bytes(G5M_BsrPattern_ID, index, 1u);
+		sum += reader->get_bytes(G5M_BsrPatternMask_ID, index, 1u);
+	}
+	*reads = bsr_bytes * 2u;
+	return sum;
+}
+
+/* The same merge as dp_G5M_load_bsr does it now, through one span per block */
+static unsigned long selftest_pattern_load_bsr_span(const struct selftest_reader *reader,
+						    unsigned long *reads)
+{
+	unsigned char *pattern_data;
+	unsigned char *mask_data;
+	unsigned long pattern_span;
+	unsigned long mask_span;
+	unsigned long bsr_bytes;
+	unsigned long index;
+	unsigned long sum = 0u;
+
+	bsr_bytes = (reader->get_header_bytes(G5M_NUMOFBSRBITS_OFFSET, G5M_NUMOFBSRBITS_BYTE_LENGTH) +
+		     7u) / 8u;
+	pattern_data = dp_get_block_span(G5M_BsrPattern_ID, 0u, &pattern_span);
+	mask_data = dp_get_block_span(G5M_BsrPatternMask_ID, 0u, &mask_span);
+	for (index = 0u; index < bsr_bytes; index++) {
+		if ((index < pattern_span) && (index < mask_span)) {
+			sum += pattern_data[index];
+			sum += mask_data[index];
+		} else {
+			sum += reader->get_bytes(G5M_BsrPattern_ID, index, 1u);
+			sum += reader->get_bytes(G5M_BsrPatternMask_ID, index, 1u);
+		}
+	}
+	*reads = bsr_bytes * 2u;
+	return sum;
+}
+
+/* Header and block fields of 2 and 4 bytes, as read by the G5 code before and between scans */
+static unsigned long selftest_pattern_fields(const struct selftest_reader *reader,
+					     unsigned long *reads)
+{
+	unsigned long sum = 0u;
+
+	sum += reader->get_header_bytes(G5M_ID_OFFSET, G5M_ID_BYTE_LENGTH);
+	sum += reader->get_header_bytes(G5M_NUMOFBSRBITS_OFFSET, G5M_NUMOFBSRBITS_BYTE_LENGTH);
+	sum += reader->get_bytes(G5M_NUMBER_OF_BLOCKS_ID, 0u, 4u);
+	sum += reader->get_bytes(G5M_datastream_ID, G5M_COMPONENT_TYPE_IN_HEADER_BYTE, 2u);
+	*reads = 4u;
+	return sum;
+}
+
+/* The reads of dp_G5M_process_data: per component the block count and the component type,
+ * then one frame after the other */
+static unsigned long selftest_pattern_process_data(const struct selftest_reader *reader,
+						   unsigned long *reads)
+{
+	unsigned long data_components;
+	unsigned long component;
+	unsigned long blocks;
+	unsigned long block;
+	unsigned long data_index = 0u;
+	unsigned long datastream_bits;
+	unsigned char *data;
+	unsigned long sum = 0u;
+
+	*reads = 0u;
+	data_components = reader->get_header_bytes(G5M_DATASIZE_OFFSET, G5M_DATASIZE_BYTE_LENGTH);
+	datastream_bits = dp_get_block_length(G5M_datastream_ID) * 8u;
+	for (component = 1u; component <= data_components; component++) {
+		blocks = reader->get_bytes(G5M_NUMBER_OF_BLOCKS_ID, ((component - 1u) * 22u) / 8u, 4u);
+		blocks = (blocks >> (((component - 1u) * 22u) % 8u)) & 0x3FFFFFu;
+		sum += reader->get_bytes(G5M_datastream_ID,
+					 G5M_COMPONENT_TYPE_IN_HEADER_BYTE + data_index / 8u, 1u);
+		sum += reader->get_bytes(G5M_datastream_ID, G5M_GEN_CERT_BYTE + data_index / 8u, 1u);
+		for (block = 0u; (block < blocks) &&
+				 (data_index + G5M_FRAME_BIT_LENGTH <= datastream_bits);
+		     block++) {
+			data = reader->get_data(G5M_datastream_ID, data_index);
+			if (data != (unsigned char *)DPNULL)
+				sum += data[0];
+			data_index += G5M_FRAME_BIT_LENGTH;
+		}
+		*reads += 3u + block;
+	}
+	return sum;
+}
+
+/*
+ * Module: selftest_time_pattern
+ * 		purpose: Runs pattern with reader until about SELFTEST_PATTERN_READS reads are made.
+ *		The scan starts every run from the header, as the block ID changes at the start of
+ *		every action.
+ * Return value:
+ * 		Time per read in ns, with *sum set to the sum of the values read.
+ *
+ */
+static double selftest_time_pattern(unsigned long (*pattern)(const struct selftest_reader *,
+							     unsigned long *),
+				    const struct selftest_reader *reader, unsigned long *sum)
+{
+	unsigned long long elapsed_ns;
+	unsigned long reads;
+	unsigned long runs;
+	unsigned long run;
+
+	scan_var_ID = Header_ID;
+	*sum = pattern(reader, &reads);
+	if (reads == 0u)
+		return 0.0;
+	runs = SELFTEST_PATTERN_READS / reads + 1u;
+	elapsed_ns = dp_timer_ns();
+	for (run = 0u; run < runs; run++) {
+		scan_var_ID = Header_ID;
+		*sum += pattern(reader, &reads);
+	}
+	elapsed_ns = dp_timer_ns() - elapsed_ns;
+	return (double)elapsed_ns / ((double)runs * (double)reads);
+}
+
+/*
+ * Module: selftest_bench_dat
+ * 		purpose: Times the reads of load_bsr and process_data through the scan, and as the
+ *		engine makes them now through the selected image.  Both must read the same values.
+ * Return value:
+ * 		Number of patterns whose values differ.
+ *
+ */
+static unsigned long selftest_bench_dat(unsigned char *file, unsigned long file_size)
+{
+	static const struct {
+		const char *name;
+		unsigned long (*baseline)(const struct selftest_reader *, unsigned long *);
+		unsigned long (*pattern)(const struct selftest_reader *, unsigned long *);
+	} patterns[] = {
+	    {"load_bsr", selftest_pattern_load_bsr, selftest_pattern_load_bsr},
+	    {"load_bsr span", selftest_pattern_load_bsr, selftest_pattern_load_bsr_span},
+	    {"process_data", selftest_pattern_process_data, selftest_pattern_process_data},
+	    {"fields", selftest_pattern_fields, selftest_pattern_fields},
+	};
+	unsigned long failures = 0u;
+	unsigned long baseline_sum;
+	unsigned long sum;
+	double baseline_ns;
+	double ns;
+	unsigned int index;
+
+	scan_file = file;
+	scan_file_size = file_size;
+	for (index = 0u; index < sizeof(patterns) / sizeof(patterns[0]); index++) {
+		baseline_ns = selftest_time_pattern(patterns[index].baseline, &selftest_scan_reader,
+						    &baseline_sum);
+		ns = selftest_time_pattern(patterns[index].pattern, &selftest_directory_reader, &sum);
+		if (sum != baseline_sum)
+			failures++;
+		printf("  %-14s scan %6.1f ns, now %6.1f ns per read%s\n", patterns[index].name,
+		       baseline_ns, ns, (sum != baseline_sum) ? ", MISMATCH" : "");
+	}
+	return failures;
+}
+
+/*
+ * Module: selftest_dat
+ * 		purpose: Loads path with dp_load_image and checks the block directory and the field
+ *		reads against a linear scan of the lookup table in a plain copy of the file.  As in
+ *		the original lookup, the first record of a block ID is used, and a block length is
+ *		cut at the end of the image.
+ * Return value:
+ * 		Number of mismatches.
+ *
+ */
+static unsigned long selftest_dat(char *path)
+{
+	struct dp_image image;
+	FILE *input;
+	unsigned char *file;
+	unsigned char listed[DP_BLOCK_DIRECTORY_SIZE];
+	unsigned long file_size;
+	unsigned long table;
+	unsigned long record;
+	unsigned long address;
+	unsigned long length;
+	unsigned long size;
+	unsigned long failures = 0u;
+	unsigned int num_vars;
+	unsigned int var_idx;
+	unsigned char var_ID;
+
+	input = fopen(path, "rb");
+	if (input == (FILE *)DPNULL) {
+		printf("%s: can't open\n", path);
+		return 1u;
+	}
+	fseek(input, 0L, SEEK_END);
+	file_size = (unsigned long)ftell(input);
+	fseek(input, 0L, SEEK_SET);
+	file = (unsigned char *)malloc(file_size + 1u);
+	if ((file == (unsigned char *)DPNULL) || (fread(file, 1u, file_size, input) != file_size) ||
+	    (file_size < MIN_IMAGE_SIZE)) {
+		printf("%s: can't read\n", path);
+		fclose(input);
+		free(file);
+		return 1u;
+	}
+	fclose(input);
+
+	memset(&image, 0, sizeof(image));
+	if (dp_load_image(path, &image) != DP_IMAGE_LOADED) {
+		printf("%s: dp_load_image failed\n", path);
+		free(file);
+		return 1u;
+	}
+	dp_select_image(&image);
+
+	size = selftest_load_le(&file[IMAGE_SIZE_OFFSET], 4u);
+	if (size > file_size)
+		size = file_size;
+	table = file[HEADER_SIZE_OFFSET];
+	num_vars = (table != 0u) ? file[table - 1u] : 0u;
+	memset(listed, 0, sizeof(listed));
+	for (var_idx = 0u; var_idx < num_vars; var_idx++) {
+		record = table + BTYES_PER_TABLE_RECORD * var_idx;
+		if (record + BTYES_PER_TABLE_RECORD > size)
+			break;
+		var_ID = file[record];
+		address = selftest_load_le(&file[record + 1u], 4u);
+		length = selftest_load_le(&file[record + 5u], 4u);
+		if ((var_ID == Header_ID) || (listed[var_ID] == TRUE) || (address >= size))
+			continue;
+		listed[var_ID] = TRUE;
+		if ((length == 0u) || (length > size - address))
+			length = size - address;
+		failures += selftest_dat_block(var_ID, file, address, length);
+	}
+	for (var_idx = 1u; var_idx < DP_BLOCK_DIRECTORY_SIZE; var_idx++) {
+		if ((listed[var_idx] == FALSE) && (dp_get_block_length((unsigned char)var_idx) != 0u)) {
+			printf("  block %u: not in the file but has a length\n", var_idx);
+			failures++;
+		}
+	}
+	failures += selftest_dat_block(Header_ID, file, 0u, size);
+
+	printf("%s: %u blocks, %s\n", path, num_vars, (failures == 0u) ? "matches" : "MISMATCH");
+	failures += selftest_bench_dat(file, size);
+	dp_deselect_image();
+	dp_unload_image(&image);
+	free(file);
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long failures;
+	int arg;
+
+	if ((argc > 1) && (strcmp(argv[1], "-h") == 0)) {
+		printf("Usage: dpselftest [DAT file ...]\n");
+		printf("Checks the CRC-16 engines, and the block directory and field reads of each DAT file,\n");
+		printf("and times the reads of load_bsr and process_data against a scan of the lookup table\n");
+		return 0;
+	}
+	failures = selftest_crc();
+	for (arg = 1; arg < argc; arg++)
+		failures += selftest_dat(argv[arg]);
+	printf("%s\n", (failures == 0u) ? "All checks passed" : "Checks FAILED");
+	return (failures == 0u) ? 0 : 1;
+}
+
+/*   *************** End of File *************** */